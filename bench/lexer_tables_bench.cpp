@@ -0,0 +1,120 @@
+// bench/lexer_tables_bench.cpp
+// Micro-benchmark: tokenizer classification with the compile-time tables (frontend/lexer_tables.hpp)
+// compared with the std::unordered_map lookups the tokenizer used before.
+#include <chrono>
+#include <cstdio>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "./frontend/lexer_tables.hpp"
+
+// ===== PREVIOUS IMPLEMENTATION =====
+const std::unordered_map<std::string, TokenType> KEYWORDS = {
+    {"while", TokenType::WHILE}, {"for", TokenType::FOR}, {"if", TokenType::IF}, {"else", TokenType::ELSE},
+    {"return", TokenType::RETURN}, {"true", TokenType::TRUE}, {"false", TokenType::FALSE},
+};
+
+const std::unordered_map<char, TokenType> CHARS = {
+    {'+', TokenType::PLUS}, {'-', TokenType::MINUS}, {'*', TokenType::MULTIPLY}, {'/', TokenType::DIVIDE},
+    {'=', TokenType::EQUALS}, {'<', TokenType::LESS}, {'>', TokenType::GREATER},
+    {'(', TokenType::OPEN_PAREN}, {')', TokenType::CLOSE_PAREN}, {'{', TokenType::OPEN_BRACE}, {'}', TokenType::CLOSE_BRACE},
+    {'[', TokenType::OPEN_BRACKET}, {']', TokenType::CLOSE_BRACKET}, {';', TokenType::SEMI_COLON}, {',', TokenType::COMMA}, {'.', TokenType::DOT},
+};
+
+const std::unordered_map<std::string, TokenType> DOUBLE_CHARS = {
+    {"==", TokenType::EQUALS_EQUALS}, {"!=", TokenType::NOT_EQUALS}, {"<=", TokenType::LESS_EQUAL}, {">=", TokenType::GREATER_EQUAL},
+};
+
+static volatile unsigned sink; // keeps the results alive
+
+template<typename Fn>
+double measure(const char* name, size_t ops, Fn&& fn) {
+    fn(); // warm up
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("  %-28s %8.2f ns/op\n", name, ns / ops);
+    return ns / ops;
+}
+
+int main() {
+    const std::vector<std::string> words = {
+        "while", "counter", "if", "x", "else", "tempA", "return", "accumulator", "true", "false",
+        "for", "iterations", "val", "i", "some-ident", "min", "max", "currentGuess", "started", "y_2",
+    };
+    const std::string punct = "+-*/=<>(){}[];,.!= <= >= == a1 \t";
+
+    const size_t ROUNDS = 200000;
+
+    // ----- keywords -----
+    printf("keywords (%zu lookups):\n", ROUNDS * words.size());
+    double oldKw = measure("unordered_map<string>", ROUNDS * words.size(), [&] {
+        unsigned acc = 0;
+        for (size_t r = 0; r < ROUNDS; r++) {
+            for (const auto& w : words) {
+                std::string buf(w); // old tokenizer collected the word into a std::string buffer
+                auto it = KEYWORDS.find(buf);
+                acc += it != KEYWORDS.end() ? (unsigned)it->second : 0;
+            }
+        }
+        sink = acc;
+    });
+    double newKw = measure("perfect hash", ROUNDS * words.size(), [&] {
+        unsigned acc = 0;
+        for (size_t r = 0; r < ROUNDS; r++) {
+            for (const auto& w : words) {
+                TokenType t = lex::KEYWORDS.find(w, lex::NOT_FOUND);
+                acc += t != lex::NOT_FOUND ? (unsigned)t : 0;
+            }
+        }
+        sink = acc;
+    });
+
+    // ----- operators & char classes -----
+    printf("chars (%zu classifications):\n", ROUNDS * punct.size());
+    double oldCh = measure("isalpha + maps", ROUNDS * punct.size(), [&] {
+        unsigned acc = 0;
+        for (size_t r = 0; r < ROUNDS; r++) {
+            for (size_t i = 0; i + 1 < punct.size(); i++) {
+                char c = punct[i];
+                if (std::isalpha(c) || std::isdigit(c)) { acc++; continue; }
+
+                std::string doubleChar;
+                doubleChar += c;
+                doubleChar += punct[i + 1];
+                auto d = DOUBLE_CHARS.find(doubleChar);
+                if (d != DOUBLE_CHARS.end()) { acc += (unsigned)d->second; continue; }
+
+                auto s = CHARS.find(c);
+                if (s != CHARS.end()) { acc += (unsigned)s->second; continue; }
+                if (std::isspace(c)) acc += 2;
+            }
+        }
+        sink = acc;
+    });
+    double newCh = measure("char table + perfect hash", ROUNDS * punct.size(), [&] {
+        unsigned acc = 0;
+        std::string_view src = punct;
+        for (size_t r = 0; r < ROUNDS; r++) {
+            for (size_t i = 0; i + 1 < src.size(); i++) {
+                char c = src[i];
+                const lex::CharInfo& info = lex::CHAR_TABLE[(unsigned char)c];
+                if (info.cls & (lex::CC_ALPHA | lex::CC_DIGIT)) { acc++; continue; }
+
+                if (info.cls & lex::CC_DOUBLE_START) {
+                    TokenType d = lex::DOUBLE_CHARS.find(src.substr(i, 2), lex::NOT_FOUND);
+                    if (d != lex::NOT_FOUND) { acc += (unsigned)d; continue; }
+                }
+
+                if (info.cls & lex::CC_SINGLE) { acc += (unsigned)info.single; continue; }
+                if (info.cls & lex::CC_SPACE) acc += 2;
+            }
+        }
+        sink = acc;
+    });
+
+    printf("speedup: keywords %.1fx, chars %.1fx\n", oldKw / newKw, oldCh / newCh);
+    return 0;
+}
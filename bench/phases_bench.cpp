@@ -0,0 +1,289 @@
+// bench/phases_bench.cpp
+// Benchmark of every compiler phase on generated programs (./workload.hpp) of growing size:
+// registry load (commands.json & snapshot), Tokenizer, Parser, Resolver + Analyzer and FunctionGenerator.
+// Every phase runs on its own input prepared outside of the timing, median and min of the repetitions are reported.
+//
+//   phases_bench [-sizes=1K,64K,1M] [-reps=7] [-depth=3] [-expr=4] [-loops=30] [-seed=1] [-mcdoc=<commands.json>]
+//                [-out=<results.json>] [-baseline=<results.json>] [-tolerance=0.15] [-tmp=<scratch dir>]
+//   phases_bench -generate=<size> [shape args] > program.mcjava
+//
+// Results are written as JSON (-out, out/bench/phases_bench.json by default). With -baseline every result is
+// compared with the one of the same name by min (the least disturbed run, the median is noisy on a busy machine),
+// one slower by more than the tolerance fails the run (exit 1). A baseline of another workload or -reps is refused.
+// Save a baseline on the machine it is compared on: cp out/bench/phases_bench.json <file>.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <unistd.h>
+
+#include "./workload.hpp"
+#include "./../libs/json.hpp"
+
+#include "./frontend/tokenizer.hpp"
+#include "./frontend/parser.hpp"
+#include "./middleend/resolver.hpp"
+#include "./middleend/analyzer.hpp"
+#include "./backend/generator.hpp"
+#include "./registries/SimplifiedCommandRegistry.hpp"
+#include "./core/options.hpp"
+#include "./core/token.hpp"
+#include "./core/unit.hpp"
+#include "./core/version.hpp"
+#include "./core/diagnostic.hpp"
+
+namespace fs = std::filesystem;
+using json = nlohmann::ordered_json;
+
+struct Result {
+    std::string phase;
+    std::string size;   // as given in -sizes, json / snapshot for the registry
+    size_t bytes;       // input size
+    double medianNs;
+    double minNs;
+
+    std::string name() const { return phase + "/" + size; }
+};
+
+// setup -> untimed, prepares the input of one run
+Result measure(const std::string& phase, const std::string& size, size_t bytes, size_t reps,
+               const std::function<void()>& setup, const std::function<void()>& run) {
+    std::vector<double> times;
+    for (size_t i = 0; i < reps; i++) {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        run();
+        times.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+
+    Result result = { phase, size, bytes, times[times.size() / 2], times.front() };
+    double mbs = bytes / (result.medianNs / 1e9) / (1024 * 1024);
+    printf("  %-10s %-8s %12.3f ms %12.3f ms %10.1f MB/s\n", phase.c_str(), size.c_str(), result.medianNs / 1e6, result.minNs / 1e6, mbs);
+    return result;
+}
+
+std::unique_ptr<CompilationUnit> makeUnit(const std::string& text) {
+    return std::unique_ptr<CompilationUnit>(new CompilationUnit{ .source = Source(text) });
+}
+
+void parse(CompilationUnit& unit, SimplifiedCommandRegistry& reg) {
+    Tokenizer tokenizer(unit.source, reg);
+    Parser parser(tokenizer, unit.source, reg, unit.arena);
+    unit.root = parser.parse();
+}
+
+std::vector<Result> benchRegistry(const std::string& mcdoc, const fs::path& tmp, size_t reps) {
+    // a copy without a snapshot next to it -> the json path can be timed again and again
+    fs::path json = tmp / "commands.json";
+    fs::path snapshot = tmp / "commands.json.snapshot";
+    fs::copy_file(mcdoc, json, fs::copy_options::overwrite_existing);
+    size_t bytes = fs::file_size(json);
+
+    std::vector<Result> results;
+    std::unique_ptr<SimplifiedCommandRegistry> reg;
+    auto fresh = [&] { reg = std::make_unique<SimplifiedCommandRegistry>(); };
+    auto load = [&] {
+        std::string err;
+        if (!reg->loadFromFile(json.string(), &err)) throw std::runtime_error("registry load failed: " + err);
+    };
+
+    results.push_back(measure("registry", "json", bytes, reps, [&] { fresh(); fs::remove(snapshot); }, load));
+    results.push_back(measure("registry", "snapshot", bytes, reps, fresh, load));
+    return results;
+}
+
+std::vector<Result> benchPhases(const std::string& text, const std::string& size, SimplifiedCommandRegistry& reg, const fs::path& tmp, size_t reps) {
+    std::vector<Result> results;
+    Options options;
+    options.silent = true;
+
+    // Tokenizer -> whole token vector, like -dump-tokens
+    auto unit = makeUnit(text);
+    std::vector<Token> tokens;
+    results.push_back(measure("tokenize", size, text.size(), reps, [&] { tokens.clear(); }, [&] {
+        Tokenizer tokenizer(unit->source, reg);
+        tokens = tokenizer.tokenize();
+    }));
+
+    // Parser -> from the tokens, into a fresh arena every time
+    std::vector<Token> input;
+    results.push_back(measure("parse", size, text.size(), reps, [&] { unit = makeUnit(text); input = tokens; }, [&] {
+        Parser parser(std::move(input), unit->source, reg, unit->arena);
+        unit->root = parser.parse();
+    }));
+
+    // Resolver + Analyzer -> on a freshly parsed tree (analysis writes into the nodes)
+    results.push_back(measure("analyze", size, text.size(), reps, [&] { unit = makeUnit(text); parse(*unit, reg); }, [&] {
+        Resolver resolver;
+        resolver.resolve(*unit->root);
+        Analyzer analyzer(options, unit->source, unit->vars);
+        analyzer.analyze(*unit->root);
+    }));
+
+    // FunctionGenerator -> into an empty directory
+    fs::path out = tmp / "functions";
+    std::unique_ptr<Analyzer> analyzer;
+    results.push_back(measure("generate", size, text.size(), reps, [&] {
+        fs::remove_all(out);
+        fs::create_directories(out);
+        unit = makeUnit(text);
+        parse(*unit, reg);
+        Resolver resolver;
+        resolver.resolve(*unit->root);
+        analyzer = std::make_unique<Analyzer>(options, unit->source, unit->vars);
+        analyzer->analyze(*unit->root);
+    }, [&] {
+        FunctionGenerator generator(out, options, analyzer->getScopes(), unit->source, unit->vars);
+        generator.generate(*unit->root);
+    }));
+
+    return results;
+}
+
+json workloadJson(const WorkloadShape& shape) {
+    return { { "depth", shape.depth }, { "expr_terms", shape.exprTerms }, { "loop_percent", shape.loopPercent }, { "seed", shape.seed } };
+}
+
+json toJson(const std::vector<Result>& results, const WorkloadShape& shape, size_t reps) {
+    json list = json::array();
+    for (const Result& r : results) {
+        list.push_back({
+            { "name", r.name() }, { "phase", r.phase }, { "bytes", r.bytes },
+            { "median_ns", r.medianNs }, { "min_ns", r.minNs },
+        });
+    }
+    return {
+        { "compiler", COMPILER_VERSION },
+        { "workload", workloadJson(shape) },
+        { "reps", reps },
+        { "results", std::move(list) },
+    };
+}
+
+// results of another workload (or number of reps) share the names but aren't comparable -> refused before running
+void checkSetup(const json& baseline, const WorkloadShape& shape, size_t reps) {
+    json workload = workloadJson(shape);
+    if (baseline.value("workload", json()) != workload) {
+        throw std::runtime_error("baseline was measured on workload " + baseline.value("workload", json()).dump() + ", this run uses " + workload.dump() +
+                                 " -> pass the same -depth / -expr / -loops / -seed or save a new baseline");
+    }
+    if (baseline.value("reps", json()) != json(reps)) {
+        throw std::runtime_error("baseline was measured with -reps=" + baseline.value("reps", json()).dump() + ", this run uses -reps=" + std::to_string(reps));
+    }
+}
+
+// true if nothing got slower than baseline * (1 + tolerance)
+bool compare(const std::vector<Result>& results, const json& baseline, double tolerance) {
+    std::unordered_map<std::string, double> before;
+    for (const json& r : baseline.at("results")) before[r.at("name").get<std::string>()] = r.at("min_ns").get<double>();
+
+    printf("min compared with the baseline (tolerance %.0f%%):\n", tolerance * 100);
+    size_t regressions = 0;
+    for (const Result& r : results) {
+        auto it = before.find(r.name());
+        if (it == before.end()) {
+            printf("  %-28s not in the baseline\n", r.name().c_str());
+            continue;
+        }
+
+        double change = r.minNs / it->second - 1;
+        bool regressed = change > tolerance;
+        if (regressed) regressions++;
+        printf("  %-28s %12.3f ms -> %12.3f ms %+7.1f%%%s\n", r.name().c_str(), it->second / 1e6, r.minNs / 1e6, change * 100, regressed ? "  REGRESSION" : "");
+    }
+
+    if (regressions > 0) fprintf(stderr, "%zu benchmark(s) regressed by more than %.0f%%\n", regressions, tolerance * 100);
+    return regressions == 0;
+}
+
+int main(int argc, char* argv[]) try {
+    std::unordered_map<std::string, std::string> args;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("-", 0) != 0) continue;
+        size_t eq = arg.find('=');
+        if (eq == std::string::npos) args[arg.substr(1)] = "true";
+        else args[arg.substr(1, eq - 1)] = arg.substr(eq + 1);
+    }
+    auto get = [&](const std::string& key, const std::string& fallback) {
+        auto it = args.find(key);
+        return it == args.end() ? fallback : it->second;
+    };
+
+    WorkloadShape shape;
+    shape.depth       = std::stoul(get("depth", "3"));
+    shape.exprTerms   = std::max(1ul, std::stoul(get("expr", "4")));
+    shape.loopPercent = std::stoul(get("loops", "30"));
+    shape.seed        = std::stoull(get("seed", "1"));
+
+    if (args.count("generate")) {
+        shape.bytes = parseSize(args["generate"]);
+        std::string text = WorkloadGenerator(shape).generate();
+        fwrite(text.data(), 1, text.size(), stdout);
+        return 0;
+    }
+
+    size_t reps = std::max(1ul, std::stoul(get("reps", "7")));
+    std::string mcdoc = get("mcdoc", "./mcdoc/commands.json");
+    std::string outPath = get("out", "out/bench/phases_bench.json");
+    double tolerance = std::stod(get("tolerance", "0.15"));
+
+    std::vector<std::string> sizes;
+    std::string list = get("sizes", "1K,64K,1M");
+    for (size_t at = 0; at <= list.size();) {
+        size_t comma = std::min(list.find(',', at), list.size());
+        if (comma > at) sizes.push_back(list.substr(at, comma - at));
+        at = comma + 1;
+    }
+
+    json baseline;
+    if (args.count("baseline")) {
+        std::ifstream file(args["baseline"]);
+        baseline = json::parse(file, nullptr, false);
+        if (!file || baseline.is_discarded() || !baseline.is_object()) throw std::runtime_error("can't read baseline " + args["baseline"]);
+        checkSetup(baseline, shape, reps);
+    }
+
+    // generated functions and the registry copy go to memory when possible -> generate times the generator, not the disk
+    std::string scratch = get("tmp", fs::is_directory("/dev/shm") ? "/dev/shm" : fs::temp_directory_path().string());
+    fs::path tmp = fs::path(scratch) / ("mcjava-bench-" + std::to_string(getpid()));
+    fs::create_directories(tmp);
+
+    printf("  %-10s %-8s %15s %15s %15s\n", "phase", "size", "median", "min", "throughput");
+    std::vector<Result> results = benchRegistry(mcdoc, tmp, reps);
+
+    SimplifiedCommandRegistry reg;
+    std::string err;
+    if (!reg.loadFromFile(mcdoc, &err)) throw std::runtime_error("registry load failed: " + err);
+
+    for (const std::string& size : sizes) {
+        shape.bytes = parseSize(size);
+        std::string text = WorkloadGenerator(shape).generate();
+        for (Result& r : benchPhases(text, size, reg, tmp, reps)) results.push_back(std::move(r));
+    }
+    fs::remove_all(tmp);
+
+    json output = toJson(results, shape, reps);
+    fs::create_directories(fs::path(outPath).parent_path());
+    std::ofstream(outPath) << output.dump(1, '\t') << "\n";
+    printf("results: %s\n", outPath.c_str());
+
+    if (!baseline.is_null() && !compare(results, baseline, tolerance)) return 1;
+    return 0;
+} catch (const CompileError& e) {
+    // a generated program has to compile, anything else is a bug in ./workload.hpp
+    std::cerr << "workload error: " << e.what() << std::endl;
+    return 1;
+} catch (const std::exception& e) {
+    std::cerr << "bench error: " << e.what() << std::endl;
+    return 1;
+}
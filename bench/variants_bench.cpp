@@ -0,0 +1,74 @@
+// bench/variants_bench.cpp
+// Walks every syntax variant of every command with CommandRegistry::VariantCursor (registries/CommandRegistry.hpp),
+// once without and once with the redirects expanded in place, and checks the walk against the memoized
+// variantCount() and getSyntaxVariants(). Exits 1 when they disagree.
+//
+//   variants_bench [-mcdoc=<commands.json>]     (other args are ignored, make bench passes BENCH_ARGS to everything)
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "./registries/CommandRegistry.hpp"
+
+int main(int argc, char* argv[]) {
+    std::string mcdoc = "./mcdoc/commands.json";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("-mcdoc=", 0) == 0) mcdoc = arg.substr(7);
+    }
+
+    CommandRegistry reg;
+    std::string err;
+    if (!reg.loadFromFile(mcdoc, &err)) {
+        fprintf(stderr, "registry load failed: %s\n", err.c_str());
+        return 1;
+    }
+
+    size_t commands = 0, mismatches = 0;
+    uint64_t variants = 0, expanded = 0, tokens = 0;
+    double walkNs = 0, expandNs = 0;
+
+    for (const std::string& cmd : reg.rootCommands()) {
+        commands++;
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t count = 0;
+        for (auto v = reg.variants(cmd); v.next(); ) {
+            count++;
+            tokens += v.path().size();
+        }
+        auto mid = std::chrono::steady_clock::now();
+        uint64_t all = 0;
+        for (auto v = reg.variants(cmd, -1); v.next(); ) all++;
+        auto end = std::chrono::steady_clock::now();
+
+        walkNs += std::chrono::duration<double, std::nano>(mid - start).count();
+        expandNs += std::chrono::duration<double, std::nano>(end - mid).count();
+        variants += count;
+        expanded += all;
+
+        // the cursor, the memoized count and the materialized list have to agree
+        size_t listed = reg.getSyntaxVariants(cmd).size();
+        if (count != reg.variantCount(cmd) || listed != count || all < count) {
+            fprintf(stderr, "  %-20s walked %llu, variantCount %llu, getSyntaxVariants %zu, expanded %llu\n", cmd.c_str(),
+                    (unsigned long long)count, (unsigned long long)reg.variantCount(cmd), listed, (unsigned long long)all);
+            mismatches++;
+        }
+    }
+
+    printf("commands: %zu\n", commands);
+    printf("  variants (redirects end them)     %10llu  %8.3f ms  %6.1f ns/variant\n",
+           (unsigned long long)variants, walkNs / 1e6, variants ? walkNs / variants : 0.0);
+    printf("  variants (redirects expanded)     %10llu  %8.3f ms  %6.1f ns/variant\n",
+           (unsigned long long)expanded, expandNs / 1e6, expanded ? expandNs / expanded : 0.0);
+    unsigned long long execute = 0;
+    for (auto v = reg.variants("execute", -1); v.next(); ) execute++;
+    printf("  execute: %llu, expanded %llu\n", (unsigned long long)reg.variantCount("execute"), execute);
+    printf("  avg tokens per variant: %.2f\n", variants ? double(tokens) / variants : 0.0);
+
+    if (mismatches > 0) {
+        fprintf(stderr, "%zu command(s) with inconsistent variants\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,170 @@
+// bench/workload.hpp
+// Deterministic generator of synthetic .mcjava programs for the benchmarks -> the same shape and seed always give
+// the same bytes on every machine (own PRNG, no std:: distributions, their output differs between standard libraries).
+// Programs always compile: variables are assigned at the top level before they're used, divisors are non-zero
+// literals and conditions are comparisons.
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct WorkloadShape {
+    size_t bytes        = 64 * 1024;    // target size, generation stops at the first top-level statement past it
+    uint32_t depth      = 3;            // max nesting of if / while blocks
+    uint32_t exprTerms  = 4;            // max operands of one expression
+    uint32_t loopPercent = 30;          // of the blocks that are while loops, the rest are if / else
+    uint64_t seed       = 1;
+};
+
+class WorkloadGenerator {
+public:
+    explicit WorkloadGenerator(const WorkloadShape& shape) : shape_(shape), state_(shape.seed) {}
+
+    std::string generate() {
+        state_ = shape_.seed;
+        out_.clear();
+        out_.reserve(shape_.bytes + 1024);
+        vars_ = 0;
+        loops_ = 0;
+
+        out_ += "// generated by bench/workload.hpp\n";
+        while (out_.size() < shape_.bytes) statement(0);
+        return out_;
+    }
+
+private:
+    const WorkloadShape shape_;
+    uint64_t state_;
+    std::string out_;
+    uint32_t vars_ = 0;     // v0 .. v<vars_ - 1> are assigned
+    uint32_t loops_ = 0;    // loop counters are named after the loop
+
+    // splitmix64
+    uint64_t next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    uint32_t below(uint32_t n) { return uint32_t(next() % n); }
+    bool chance(uint32_t percent) { return below(100) < percent; }
+
+    void indent(uint32_t level) { out_.append(level * 4, ' '); }
+
+    void var(uint32_t id) {
+        out_ += 'v';
+        out_ += std::to_string(id);
+    }
+
+    void operand() {
+        if (vars_ == 0 || chance(30)) out_ += std::to_string(below(1000));
+        else var(below(vars_));
+    }
+
+    void expression() {
+        uint32_t terms = 1 + below(shape_.exprTerms);
+        bool paren = terms > 2 && chance(30);
+        operand();
+        for (uint32_t i = 1; i < terms; i++) {
+            if (paren && i == 1) {
+                out_ += " * (";
+                operand();
+                out_ += " + ";
+                operand();
+                out_ += ")";
+                continue;
+            }
+            switch (below(4)) {
+                case 0: out_ += " + "; operand(); break;
+                case 1: out_ += " - "; operand(); break;
+                case 2: out_ += " * "; operand(); break;
+                default: out_ += " / "; out_ += std::to_string(1 + below(9)); break; // never zero
+            }
+        }
+    }
+
+    void condition() {
+        static const char* OPS[] = { " < ", " > ", " <= ", " >= ", " == ", " != " };
+        expression();
+        out_ += OPS[below(6)];
+        operand();
+    }
+
+    void statement(uint32_t level) {
+        uint32_t roll = below(100);
+
+        // new variables only at the top level -> they stay visible to everything after them
+        if (level == 0 && (vars_ < 4 || roll < 15)) {
+            var(vars_);
+            out_ += " = ";
+            expression();
+            out_ += ";\n";
+            vars_++;
+            return;
+        }
+
+        indent(level);
+        if (roll < 55) {
+            var(below(vars_));
+            out_ += " = ";
+            expression();
+            out_ += ";\n";
+        } else if (roll < 70 || level >= shape_.depth) {
+            if (chance(50)) {
+                out_ += "say \"value\" ";
+                var(below(vars_));
+                out_ += "\n";
+            } else {
+                out_ += "say \"step\"\n";
+            }
+        } else if (chance(shape_.loopPercent)) {
+            loop(level);
+        } else {
+            branch(level);
+        }
+    }
+
+    void block(uint32_t level) {
+        uint32_t count = 1 + below(4);
+        for (uint32_t i = 0; i < count; i++) statement(level + 1);
+    }
+
+    void branch(uint32_t level) {
+        out_ += "if (";
+        condition();
+        out_ += ") {\n";
+        block(level);
+        indent(level);
+        if (chance(50)) {
+            out_ += "} else {\n";
+            block(level);
+            indent(level);
+        }
+        out_ += "}\n";
+    }
+
+    // counted loop, the counter is assigned right before it (in the same block)
+    void loop(uint32_t level) {
+        std::string counter = "i" + std::to_string(loops_++);
+        out_ += counter + " = 0;\n";
+        indent(level);
+        out_ += "while (" + counter + " < " + std::to_string(1 + below(50)) + ") {\n";
+        block(level);
+        indent(level + 1);
+        out_ += counter + " = " + counter + " + 1;\n";
+        indent(level);
+        out_ += "}\n";
+    }
+};
+
+// "64K", "1M", "100M", "512" -> bytes
+inline size_t parseSize(const std::string& text) {
+    size_t value = std::stoull(text);
+    switch (text.empty() ? ' ' : text.back()) {
+        case 'K': case 'k': return value * 1024;
+        case 'M': case 'm': return value * 1024 * 1024;
+        case 'G': case 'g': return value * 1024 * 1024 * 1024;
+        default: return value;
+    }
+}
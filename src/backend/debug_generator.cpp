@@ -2,10 +2,14 @@
 #include "./debug_generator.hpp"
 
 #include "./../core/ast.hpp"
+#include "./../core/source.hpp"
+#include "./../core/visitor.hpp"
 
-class DebugGenerator::Impl : public ASTVisitor {
+class DebugGenerator::Impl : public ASTVisitor<DebugGenerator::Impl> {
 private:
     std::ostream& output_;
+    const Source& source_;
+    const VarPool& vars_;
 
     int indent_ = 0;
     
@@ -23,21 +27,30 @@ private:
         output_ << "\n";
     }
 
-    inline ASTReturn done() { return std::monostate{}; }
-    inline void visit(ASTNode& node) { node.accept(*this); }
+    // tokens without value (keywords) are printed as fallback
+    std::string_view valueOr(const Token& token, std::string_view fallback) const {
+        return tokenHasValue(token.type) ? source_.lexeme(token) : fallback;
+    }
+
 
 public:
-    Impl(std::ostream& out) : output_(out) {}
+    Impl(std::ostream& out, const Source& source, const VarPool& vars) : output_(out), source_(source), vars_(vars) {}
 
     void generate(ASTNode& node) {
-        node.accept(*this);
+        visit(node);
     }
 
-    ASTReturn visitCommand(const CommandNode& node) override {
+    void visitCommand(const CommandNode& node) {
         printAnnotations(node);
 
         indent();
-        output_ << "Command: " << node.command.value.value_or("[no cmd]") << "\n";
+        output_ << "Command: " << valueOr(node.command, "[no cmd]") << "\n";
+        if (node.text.length > 0) {
+            indent_++;
+            indent();
+            output_ << "Text: " << source_.lexeme(node.text) << "\n";
+            indent_--;
+        }
 
         indent_++;
         for (const auto& arg : node.args) {
@@ -46,22 +59,21 @@ public:
         indent_--;
 
         output_ << "\n";
-        return done();
     }
     
-    ASTReturn visitVarDecl(const VarDeclNode& node) override {
+    void visitVarDecl(const VarDeclNode& node) {
         printAnnotations(node);
 
         indent();
         
         if (node.isAnalyzed) {
-            std::string name = node.varInfo->name;
-            std::string type = ", Type: " + dataTypeToString(node.varInfo->dataType);
-            std::string used = node.varInfo->isUsed ? ", [USED]" : ", [UNUSED]";
-            std::string isConst = node.varInfo->isConstant ? ", [CONST: " + node.varInfo->constValue + "]" : ", [NON-CONST]";
+            std::string_view name = vars_[node.varId].name.str();
+            std::string type = ", Type: " + dataTypeToString(vars_[node.varId].dataType);
+            std::string used = vars_[node.varId].isUsed ? ", [USED]" : ", [UNUSED]";
+            std::string isConst = vars_[node.varId].isConstant ? ", [CONST: " + vars_[node.varId].constValue.toString() + "]" : ", [NON-CONST]";
             output_ << "VarDecl: " << name << type << used << isConst << "\n";
         } else {
-            output_ << "VarDecl: " << node.name.value.value_or("[no name]") << "\n";
+            output_ << "VarDecl: " << valueOr(node.name, "[no name]") << "\n";
         }
 
         indent_++;
@@ -69,41 +81,39 @@ public:
         indent_--; 
 
         output_ << "\n";
-        return done();
     }
 
-    ASTReturn visitExpr(const ExprNode& node) override {
+    void visitExpr(const ExprNode& node) {
         printAnnotations(node);
 
         indent();
         if (node.isAnalyzed) {
-            std::string value = node.token.value.value();
+            std::string_view value = source_.lexeme(node.token);
             std::string tokenType = " [" + tokenTypeToString(node.token.type) + "]"; 
-            std::string type = ", Type: " + dataTypeToString(node.varInfo->dataType);
-            std::string isConst = (node.varInfo->isConstant && !node.forceDynamic) ? ", [CONST: " + node.varInfo->constValue + "]" : ", [NON-CONST]";
+            std::string type = ", Type: " + dataTypeToString(vars_[node.varId].dataType);
+            std::string isConst = (vars_[node.varId].isConstant && !node.forceDynamic) ? ", [CONST: " + vars_[node.varId].constValue.toString() + "]" : ", [NON-CONST]";
 
             output_ << "Expr: " << value << tokenType << type << isConst << "\n";
         } else {
-            output_ << "Expr: " << node.token.value.value_or("[no value]") 
+            output_ << "Expr: " << valueOr(node.token, "[no value]") 
                 << " [" << tokenTypeToString(node.token.type) << "], "
                 << "\n";
         }
-        return done();
     }
 
-    ASTReturn visitBinaryOp(const BinaryOpNode& node) override {
+    void visitBinaryOp(const BinaryOpNode& node) {
         printAnnotations(node);
 
         indent();
         if (node.isAnalyzed) {
-            std::string value = node.op.value.value();
+            std::string_view value = source_.lexeme(node.op);
             std::string tokenType = " [" + tokenTypeToString(node.op.type) + "]"; 
-            std::string type = ", Type: " + dataTypeToString(node.varInfo->dataType);
-            std::string isConst = node.varInfo->isConstant ? ", [CONST: " + node.varInfo->constValue + "]" : ", [NON-CONST]";
+            std::string type = ", Type: " + dataTypeToString(vars_[node.varId].dataType);
+            std::string isConst = vars_[node.varId].isConstant ? ", [CONST: " + vars_[node.varId].constValue.toString() + "]" : ", [NON-CONST]";
 
             output_ << "BinaryOp: " << value << tokenType << type << isConst << "\n";
         } else {
-            output_ << "BinaryOp: " << node.op.value.value_or("[no op]") 
+            output_ << "BinaryOp: " << valueOr(node.op, "[no op]") 
                 << " [" << tokenTypeToString(node.op.type) << "]," << "\n";
         }
 
@@ -112,10 +122,9 @@ public:
         visit(*node.right);
         indent_--; 
 
-        return done();
     }
 
-    ASTReturn visitIf(const IfNode& node) override {
+    void visitIf(const IfNode& node) {
         printAnnotations(node);
         
         indent();
@@ -137,10 +146,9 @@ public:
         }
 
         output_ << "\n";
-        return done();
     }
 
-    ASTReturn visitWhile(const WhileNode& node) override {
+    void visitWhile(const WhileNode& node) {
         printAnnotations(node);
 
         indent();
@@ -153,10 +161,9 @@ public:
         indent_--;
 
         output_ << "\n";
-        return done();
     }
 
-    ASTReturn visitScope(const ScopeNode& node) override {
+    void visitScope(const ScopeNode& node) {
         printAnnotations(node);
 
         indent();
@@ -172,14 +179,13 @@ public:
         output_ << "}\n";
 
         output_ << "\n";
-        return done();
     }
 
 };
 
 // ========== WRAPPER ==========
-DebugGenerator::DebugGenerator(std::ostream& out)
-    : pImpl(std::make_unique<Impl>(out)) {}
+DebugGenerator::DebugGenerator(std::ostream& out, const Source& source, const VarPool& vars)
+    : pImpl(std::make_unique<Impl>(out, source, vars)) {}
 
 DebugGenerator::~DebugGenerator() = default; // Needed for unique_ptr<Impl>
 
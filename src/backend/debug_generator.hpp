@@ -4,13 +4,14 @@
 #include <memory>
 #include <ostream>
 
-#include "./../core/visitor.hpp"
-
 struct ASTNode;
+class Source;
+class VarPool;
 
 class DebugGenerator {
 public:
-    DebugGenerator(std::ostream& out);
+    // vars -> semantic data, only read for analyzed nodes
+    DebugGenerator(std::ostream& out, const Source& source, const VarPool& vars);
     ~DebugGenerator();
 
     void generate(ASTNode& node);
@@ -1,24 +1,44 @@
 // backend/generator.cpp
 #include "./generator.hpp"
 
+#include <algorithm>
 #include <set>
 #include <iostream>
 #include <fstream>
+#include <unordered_map>
 
 #include "./../core/ast.hpp"
 #include "./../core/options.hpp"
+#include "./../core/source.hpp"
 #include "./../core/visitor.hpp"
+#include "./../core/diagnostic.hpp"
+#include "./../core/version.hpp"
+#include "./../core/trace.hpp"
+#include "./../core/stats.hpp"
+#include "./../middleend/hasher.hpp"
 
-class FunctionGenerator::Impl : public ASTVisitor {
+class FunctionGenerator::Impl : public ASTVisitor<FunctionGenerator::Impl, VarInfo*> {
 private:
     const fs::path& path_;
     const Options& options_;
+    const Source& source_;
+    VarPool& vars_;
 
     const std::string functionNamespace_;
 
     std::vector<std::shared_ptr<Scope>> allScopes_;
     std::vector<std::shared_ptr<Scope>> scopeStack_;
-    size_t nextScopeIdx = 0;
+    std::vector<std::unique_ptr<trace::Span>> scopeSpans_; // -trace: one per scope on the stack
+    size_t extraScopes_ = 0;  // bodies without a block of their own (if (x) say x;)
+
+    std::vector<fs::path> written_; // every function file saved, in generation order
+    OptimizationStats stats_;
+
+    // -incremental
+    std::unique_ptr<StructuralHasher> hasher_;
+    std::unordered_map<std::string, std::vector<std::string>> previous_;  // functions of the last build -> functions they call (manifest)
+    std::unordered_map<std::string, std::vector<std::string>> functions_; // same for this build
+    std::vector<std::vector<std::string>> calls_;                         // functions called by each scope on the stack
 
     Scope& getCurrentScope() {
         if (scopeStack_.empty()) error("Tried to access empty scope stack");
@@ -29,16 +49,28 @@ private:
         return getCurrentScope().output;
     }
     
-    // to get the next scope we can traverse the scopes by nextScopeIdx and because analyzer indexes them in the same order
-    // as we generate them we can be sure that the next scope will be the correct one for the current generated code
-    // i think this is the case, but im not sure
-    void enterScope() {
-        auto existingScope = allScopes_.at(nextScopeIdx++);
+    // a block body is the analyzer's scope with the same id (resolver numbers them), other bodies
+    // (if (x) say x;) never had a scope -> they get a new one numbered after the analyzer's
+    // inlined static branches don't enter a scope at all, so the generator can't just take the next one in order
+    // name overrides the scope name (-incremental)
+    void enterScope(const ASTNode* body, const std::string& name = "") {
+        const ScopeNode* block = body->as<ScopeNode>();
+        std::shared_ptr<Scope> scope;
+        if (block) {
+            scope = allScopes_.at(block->scopeId);
+        } else {
+            scope = std::make_shared<Scope>();
+            scope->id = allScopes_.size() + extraScopes_++;
+            scope->name = "scope_" + std::to_string(scope->id);
+        }
         
-        std::string name = scopeStack_.empty() ? "start.mcfunction" : (existingScope->name + ".mcfunction");
-        existingScope->path = (path_ / name);
+        if (!name.empty()) scope->name = name;
+        std::string fileName = scopeStack_.empty() ? "start.mcfunction" : (scope->name + ".mcfunction");
+        scope->path = (path_ / fileName);
         
-        scopeStack_.push_back(existingScope);
+        scopeStack_.push_back(scope);
+        if (options_.incremental) calls_.emplace_back();
+        if (trace::enabled()) scopeSpans_.push_back(std::make_unique<trace::Span>("function", fileName));
     }
     
     void exitScope() {
@@ -49,58 +81,92 @@ private:
         // nothing to generate
         if (scope.output.str().empty()) {
             if (!options_.silent) std::cout << "Scope '" << scope.name << "' is empty, skipping file generation.\n";
+            stats_.functionsSkipped++;
             scopeStack_.pop_back();
+            if (!scopeSpans_.empty()) scopeSpans_.pop_back();
+            if (options_.incremental) calls_.pop_back();
             return;
         }
         
-        // save to file
-        std::ofstream file(scope.path, std::ios::out);
-        if (!file.is_open()) error("Could not save function file!");
-
         // last scope (global)
-        if (scopeStack_.size() == 1) {
-            std::string body = scope.output.str();
-            std::string header = prepareScoreboards();
-            
-            file << header << body;
-        } else {
-            file << scope.output.str();
+        std::string content = scope.output.str();
+        if (scopeStack_.size() == 1) content = prepareScoreboards() + content;
+
+        written_.push_back(scope.path);
+        stats_.functionsEmitted++;
+        stats_.commands.emplace_back(functionNamespace_ + scope.path.stem().string(), countCommands(content));
+
+        if (options_.incremental) {
+            std::string name = scope.path.stem().string();
+            functions_[name] = std::move(calls_.back());
+            calls_.pop_back();
+            if (!calls_.empty()) calls_.back().push_back(name);
+        }
+
+        // start.mcfunction is always generated -> it's left alone if nothing in it changed
+        if (!options_.incremental || !sameContent(scope.path, content)) {
+            // save to file, an old file is removed first -> it may be a hard link into the compile cache (driver/cache.hpp)
+            trace::Span writing("write", scope.path.filename().string());
+            std::error_code ec;
+            fs::remove(scope.path, ec);
+            std::ofstream file(scope.path, std::ios::out);
+            if (!file.is_open()) error("Could not save function file!");
+
+            file << content;
+            file.close();
         }
 
-        file.close();
         scopeStack_.pop_back();
+        if (!scopeSpans_.empty()) scopeSpans_.pop_back();
     }
 
-    inline std::shared_ptr<VarInfo> visit(ASTNode& node) { return node.visit<std::shared_ptr<VarInfo>>(*this); }
-
 public:
 
-    Impl(fs::path& path, Options& options, std::vector<std::shared_ptr<Scope>> scopes) 
-        : path_(path), options_(options),  functionNamespace_(options_.dpPrefix + ":" + options_.dpPath), allScopes_(std::move(scopes)) {}
+    Impl(fs::path& path, Options& options, std::vector<std::shared_ptr<Scope>> scopes, const Source& source, VarPool& vars) 
+        : path_(path), options_(options), source_(source), vars_(vars), functionNamespace_(options_.dpPrefix + ":" + options_.dpPath), allScopes_(std::move(scopes)) {
+        
+        if (options_.incremental) {
+            // everything that changes every function at once
+            uint64_t seed = compilerId();
+            seed = hashBytes(functionNamespace_, seed);
+            uint8_t flags = (options_.doConstantFolding ? 1 : 0) | (options_.removeUnusedVars ? 2 : 0);
+            seed = hashBytes(&flags, sizeof(flags), seed);
+
+            hasher_ = std::make_unique<StructuralHasher>(source_, vars_, allScopes_, seed);
+            loadManifest();
+        }
+    }
 
     void generate(ASTNode& node) {
         visit(node);
+
+        if (options_.incremental) {
+            finishIncremental();
+        }
     }
 
-    ASTReturn visitCommand(const CommandNode& node) override {
+    const std::vector<fs::path>& files() const { return written_; }
+    const OptimizationStats& stats() const { return stats_; }
+
+    VarInfo* visitCommand(const CommandNode& node) {
         generateCommand(node);
         return nullptr;
     }
 
-    ASTReturn visitVarDecl(const VarDeclNode& node) override {
+    VarInfo* visitVarDecl(const VarDeclNode& node) {
         generateVarDecl(node);
         return nullptr;
     }
 
-    ASTReturn visitExpr(const ExprNode& node) override {
+    VarInfo* visitExpr(const ExprNode& node) {
         return generateExpr(node); 
     }
 
-    ASTReturn visitBinaryOp(const BinaryOpNode& node) override {
+    VarInfo* visitBinaryOp(const BinaryOpNode& node) {
         return generateBinaryOp(node);
     }
 
-    ASTReturn visitIf(const IfNode& node) override {
+    VarInfo* visitIf(const IfNode& node) {
         if (node.elseBranch) {
             generateIfWithElse(node);
         } else {
@@ -109,12 +175,12 @@ public:
         return nullptr;
     }
 
-    ASTReturn visitWhile(const WhileNode& node) override {
+    VarInfo* visitWhile(const WhileNode& node) {
         generateWhile(node);
         return nullptr;
     }
 
-    ASTReturn visitScope(const ScopeNode& node) override {
+    VarInfo* visitScope(const ScopeNode& node) {
         generateScope(node);
         return nullptr;
     }
@@ -122,29 +188,35 @@ public:
 
 private:
     void generateCommand(const CommandNode& node) {
-        // only works for say
-        std::string cmdKey = node.command.value.value();
-
-        if (cmdKey != "say") error("Generator only supports 'say' command");
+        std::string_view cmdKey = source_.lexeme(node.command);
+
+        // every command except say was already validated by the parser -> emitted as written
+        if (cmdKey != "say") {
+            auto& output = getCurrentOutput();
+            output << cmdKey;
+            if (node.text.length > 0) output << ' ' << source_.lexeme(node.text);
+            output << "\n";
+            return;
+        }
         
         std::ostringstream ss;
         ss << "tellraw @a [";
 
         for (const auto& arg : node.args) {
-            ExprNode* exprNode = dynamic_cast<ExprNode*>(arg.get());
+            const ExprNode* exprNode = arg->as<ExprNode>();
             if (exprNode) {                
                 if (exprNode->token.type == TokenType::STRING_LIT) {
-                    ss << "{\"text\":\"" << exprNode->token.value.value() << "\"},";
+                    ss << "{\"text\":\"" << source_.lexeme(exprNode->token) << "\"},";
                     continue;
-                } else if (exprNode->varInfo->isConstant) {
-                    ss << "{\"text\":\"" << exprNode->varInfo->constValue << "\"},";
+                } else if (vars_[exprNode->varId].isConstant) {
+                    ss << "{\"text\":\"" << vars_[exprNode->varId].constValue << "\"},";
                     continue;
                 }
             }
 
-            BinaryOpNode* binOpNode = dynamic_cast<BinaryOpNode*>(arg.get());
-            if (binOpNode && binOpNode->varInfo->isConstant) {                
-                ss << "{\"text\":\"" << binOpNode->varInfo->constValue << "\"},";
+            const BinaryOpNode* binOpNode = arg->as<BinaryOpNode>();
+            if (binOpNode && vars_[binOpNode->varId].isConstant) {                
+                ss << "{\"text\":\"" << vars_[binOpNode->varId].constValue << "\"},";
                 continue;
             }
 
@@ -162,7 +234,8 @@ private:
     void generateVarDecl(const VarDeclNode& node) {
 
         // dont emit unused variables
-        if (!node.varInfo->isUsed && options_.removeUnusedVars) {
+        if (!vars_[node.varId].isUsed && options_.removeUnusedVars) {
+            stats_.eliminatedVars++;
             return;
         }
 
@@ -186,13 +259,14 @@ private:
         // but we still arent using the x variable
         // 
         // NOTE: it doest work when expression folding is disabled
-        if (node.varInfo->isConstant && node.varInfo->isUsed && options_.doConstantFolding && !isExternal && options_.removeUnusedVars) { // we dont need to add node.varInfo->isUsed -> all unused were remove above
+        if (vars_[node.varId].isConstant && vars_[node.varId].isUsed && options_.doConstantFolding && !isExternal && options_.removeUnusedVars) { // we dont need to add vars_[node.varId].isUsed -> all unused were remove above
+            stats_.eliminatedVars++;
             return;
         }
 
 
 
-        std::string varName = node.varInfo->name;
+        SymbolId varName = vars_[node.varId].name;
         auto& output = getCurrentOutput();
 
         // if is external check if value existis and if not then set it to default value
@@ -201,14 +275,14 @@ private:
             // execute if score %i mcjava_sb_scope_0 matches 0 run scoreboard players set %i mcjava_sb_scope_0 10
 
             output << "#Debug: External variable " << varName << "\n";
-            output << "execute store success score " << "%e" << " " << node.varInfo->storageIdent << " run scoreboard players get " << varName << " " << node.varInfo->storageIdent << "\n";
+            output << "execute store success score " << "%e" << " " << vars_[node.varId].storageIdent << " run scoreboard players get " << varName << " " << vars_[node.varId].storageIdent << "\n";
             
-            if (!node.varInfo->constValue.empty()) {
-                output << "execute if score %e " << node.varInfo->storageIdent << " matches 0 run scoreboard players set " << varName << " " << node.varInfo->storageIdent << " " << node.varInfo->constValue << "\n";
+            if (!vars_[node.varId].constValue.empty()) {
+                output << "execute if score %e " << vars_[node.varId].storageIdent << " matches 0 run scoreboard players set " << varName << " " << vars_[node.varId].storageIdent << " " << vars_[node.varId].constValue << "\n";
             } else {
-                VarInfo tempVar = *visit(*node.value);
+                const VarInfo& tempVar = *visit(*node.value);
 
-                output << "execute if score %e " << node.varInfo->storageIdent << " matches 0 run scoreboard players operation " << varName << " " << node.varInfo->storageIdent << " = " << tempVar.storagePath << " " << tempVar.storageIdent << "\n";
+                output << "execute if score %e " << vars_[node.varId].storageIdent << " matches 0 run scoreboard players operation " << varName << " " << vars_[node.varId].storageIdent << " = " << tempVar.storagePath << " " << tempVar.storageIdent << "\n";
             }
             return;
         }
@@ -216,23 +290,23 @@ private:
        
 
        
-        if (node.varInfo->isConstant) {
+        if (vars_[node.varId].isConstant) {
             output << "#Debug: Constant var\n";
-            output << "scoreboard players set " << varName << " " << node.varInfo->storageIdent << " " << node.varInfo->constValue << "\n";
+            output << "scoreboard players set " << varName << " " << vars_[node.varId].storageIdent << " " << vars_[node.varId].constValue << "\n";
         } else {
-            VarInfo tempVar = *visit(*node.value);
+            const VarInfo& tempVar = *visit(*node.value);
 
             output << "#Debug: Dynamic var \n";
-            output << "scoreboard players operation " << varName << " " << node.varInfo->storageIdent << " = " << tempVar.storagePath << " " << tempVar.storageIdent << "\n";
+            output << "scoreboard players operation " << varName << " " << vars_[node.varId].storageIdent << " = " << tempVar.storagePath << " " << tempVar.storageIdent << "\n";
         }
     }
 
 
 
     // LEFT UNREFACTORED FOR NOW -> NOT SURE IF THIS IS THE 100% CORRECT 
-    std::shared_ptr<VarInfo> generateExpr(const ExprNode& node) {
+    VarInfo* generateExpr(const ExprNode& node) {
         // just assigns value to variable
-        std::string tokValue = node.token.value.value(); // variable name in user code
+        // variable name in user code is node.symbol
         //std::string varName = "%" +  tokValue; // won't collide with any user defined variables
 
         //auto& output = getCurrentOutput();
@@ -241,29 +315,30 @@ private:
         //     .storageType = VarStorageType::SCOREBOARD,
         //     .storageIdent = currentSb,
         //     .storagePath = varName,
-        //     .isConstant = node.varInfo->isConstant,
-        //     .constValue = node.varInfo->constValue,
+        //     .isConstant = vars_[node.varId].isConstant,
+        //     .constValue = vars_[node.varId].constValue,
         // };
 
         // if constant -> dont generate, higher node should implement it properly
-        if(node.varInfo->isConstant && !node.forceDynamic) {
+        if(vars_[node.varId].isConstant && !node.forceDynamic) {
             
             // we dont want to change anything in variables -> just generate it
-            //node.varInfo->storagePath = tokValue;
-            //node.varInfo->storageIdent = getCurrentScoreboard();
-            return node.varInfo;
+            //vars_[node.varId].storagePath = tokValue;
+            //vars_[node.varId].storageIdent = getCurrentScoreboard();
+            return &vars_[node.varId];
         }
 
         // this block appears to be unreachable
-        /*if (node.varInfo->isConstant) {
+        /*if (vars_[node.varId].isConstant) {
             output << "#Debug: Constant Expression\n";
-            output << "scoreboard players set " << varName << " " << currentSb << " " << node.varInfo->constValue << "\n";
+            output << "scoreboard players set " << varName << " " << currentSb << " " << vars_[node.varId].constValue << "\n";
         } else */
 
         {
             // retrive variable -> variable exists because analyzer checked it
             //auto varInfo = variables_.at(node.token.value.value());
-            auto varInfo = getCurrentScope().lookup(tokValue);
+            // binding from the resolver -> slot of the declaring scope holds the current version of the variable
+            VarInfo* varInfo = &vars_[allScopes_[node.binding.scope]->slots[node.binding.slot]];
 
             // can be wrong but we dont need to emits anything becouse we are only copying this value, and
             // the binary operation copy values that they change by themselves
@@ -308,21 +383,21 @@ private:
       is the variable that we are setting to
     */
     
-    std::shared_ptr<VarInfo> generateBinaryOp(const BinaryOpNode& node) {
+    VarInfo* generateBinaryOp(const BinaryOpNode& node) {
         //auto currentSb = getCurrentScoreboard();
         auto& output = getCurrentOutput();
         
         // we can generate these 2 nodes because there is at least 1 variable -> analyzer combined all 2 constants binary operators
-        VarInfo leftVar  = *visit(*node.left);
-        VarInfo rightVar = *visit(*node.right);
+        const VarInfo& leftVar = *visit(*node.left);
+        const VarInfo& rightVar = *visit(*node.right);
 
         // we dont want to change anything in variables -> just generate it
         //std::string tempVarName = getTempVarName();
-        //node.varInfo->storagePath  = tempVarName;
-        //node.varInfo->storageIdent = currentSb;
+        //vars_[node.varId].storagePath  = tempVarName;
+        //vars_[node.varId].storageIdent = currentSb;
 
-        std::string tempVarName = node.varInfo->storagePath;
-        std::string tempVarSb   = node.varInfo->storageIdent;
+        SymbolId tempVarName = vars_[node.varId].storagePath;
+        SymbolId tempVarSb   = vars_[node.varId].storageIdent;
 
         switch (node.op.type) 
         {
@@ -378,7 +453,7 @@ private:
         }
         case TokenType::MULTIPLY :
         case TokenType::DIVIDE : {
-            std::string comparator = node.op.value.value() + "=";
+            std::string comparator = std::string(source_.lexeme(node.op)) + "=";
 
             if (rightVar.isConstant) {
                 output << "#Debug: BinaryOp -> Arithmetic operation (PREPARE) -> rightVar is constant\n";
@@ -398,7 +473,7 @@ private:
         case TokenType::GREATER :
         case TokenType::LESS_EQUAL :
         case TokenType::GREATER_EQUAL : {
-            std::string comparator = node.op.value.value();
+            std::string comparator(source_.lexeme(node.op));
 
             if (leftVar.isConstant && rightVar.isConstant) {
                 // handled by if(rightVar.isConstant) -> comparision needs at least one dynamic variable, so we cannot optimize it,
@@ -409,7 +484,7 @@ private:
             }
            
             if (rightVar.isConstant) {
-                int value = std::stoi(rightVar.constValue);
+                int64_t value = rightVar.constValue.value; // 64-bit -> +1 / -1 can't overflow
 
                 // x > 1   ->  matches 2..
                 // x < 1   ->  matches ..0
@@ -433,7 +508,7 @@ private:
 
             if (leftVar.isConstant) {
                 // flip comparator & vars
-                int value = std::stoi(leftVar.constValue);
+                int64_t value = leftVar.constValue.value;
 
                 // 1 > x   ->  x < 1   ->  matches ..0
                 // 1 < x   ->  x > 1   ->  matches 2..
@@ -466,7 +541,7 @@ private:
         
         case TokenType::EQUALS_EQUALS : {
             if (rightVar.isConstant) {
-                std::string value = rightVar.constValue;
+                const Constant& value = rightVar.constValue;
 
                 output << "#DEBUG: BinaryOp -> Equals Comparison operation -> RightVar is const\n";
                 output << "execute store success score " << tempVarName << " " << tempVarSb 
@@ -477,7 +552,7 @@ private:
             }
 
             if (leftVar.isConstant) {
-                std::string value = leftVar.constValue;
+                const Constant& value = leftVar.constValue;
 
                 output << "#DEBUG: BinaryOp -> Equals Comparison operation -> LeftVar is const\n";
                 output << "execute store success score " << tempVarName << " " << tempVarSb 
@@ -496,7 +571,7 @@ private:
         case TokenType::NOT_EQUALS : {
 
             if (rightVar.isConstant) {
-                std::string value = rightVar.constValue;
+                const Constant& value = rightVar.constValue;
 
                 output << "#DEBUG: BinaryOp -> Not Equals Comparison operation -> RightVar is const\n";
                 output << "execute store success score " << tempVarName << " " << tempVarSb 
@@ -507,7 +582,7 @@ private:
             }
 
             if (leftVar.isConstant) {
-                std::string value = leftVar.constValue;
+                const Constant& value = leftVar.constValue;
 
                 output << "#DEBUG: BinaryOp -> Not Equals Comparison operation -> LeftVar is const\n";
                 output << "execute store success score " << tempVarName << " " << tempVarSb 
@@ -528,7 +603,7 @@ private:
             error("Unknown Token Type in binary operator");
         }
 
-        return node.varInfo;
+        return &vars_[node.varId];
     }
 
 
@@ -539,28 +614,30 @@ private:
 
         // STATIC :
         if (node.isConditionConstant) {
-            ASTNode* branch     = node.conditionValue == true ? node.thenBranch.get() : node.elseBranch.get();
+            ASTNode* branch     = node.conditionValue == true ? node.thenBranch : node.elseBranch;
             std::string comment = node.conditionValue == true ? "# Static Then Body\n" : "# Static Else Body\n";
             
             auto& mainOutput = getCurrentOutput();
             mainOutput << comment;
             appendBranch(branch);
+            stats_.inlinedBranches++;
+            stats_.removedBranches++;
     
             return;
         }
 
         /// DYNAMIC :
-        VarInfo conditionVar = *visit(*node.condition);      
+        const VarInfo& conditionVar = *visit(*node.condition);      
 
         // then branch
         std::string thenComment = "# Then Body\n";
-        std::string thenAdditional = "execute unless score " + conditionVar.storagePath + " " + conditionVar.storageIdent + " matches 1 run return 1\n";
-        std::string thenScopeName = generateBranch(node.thenBranch.get(), thenComment + thenAdditional);
+        std::string thenAdditional = "execute unless score " + std::string(conditionVar.storagePath.str()) + " " + std::string(conditionVar.storageIdent.str()) + " matches 1 run return 1\n";
+        std::string thenScopeName = generateBranch(node.thenBranch, functionName({ node.condition, node.thenBranch }, Body::THEN), thenComment + thenAdditional);
 
 
         // else scope
         std::string elseComment = "# Else Body\n";
-        std::string elseScopeName = generateBranch(node.elseBranch.get(), elseComment);
+        std::string elseScopeName = generateBranch(node.elseBranch, functionName({ node.elseBranch }, Body::ELSE), elseComment);
 
         auto& mainOutput = getCurrentOutput();
         mainOutput << "# Check condition  'if'\n";        
@@ -568,8 +645,11 @@ private:
         mainOutput << "execute if function " << functionNamespace_ << thenScopeName << " run function " << functionNamespace_ << elseScopeName << "\n";
     }
 
-    std::string generateBranch(ASTNode* body, const std::string& additionalBefore = "", const std::string& additionalAfter = "") {
-        enterScope();
+    // name is empty unless -incremental
+    std::string generateBranch(ASTNode* body, const std::string& name, const std::string& additionalBefore = "", const std::string& additionalAfter = "") {
+        if (keep(name)) return name;
+
+        enterScope(body, name);
         std::string scopeName = getCurrentScope().name;
         auto& output = getCurrentOutput();
 
@@ -584,7 +664,7 @@ private:
     }
 
     void appendBranch(ASTNode* body){
-        auto scopeNode = dynamic_cast<ScopeNode*>(body);
+        auto scopeNode = body->as<ScopeNode>();
         if (!scopeNode) {
             // single statement
             visit(*body);
@@ -606,14 +686,18 @@ private:
         
         // STATIC :
         if (node.isConditionConstant) {
-            if (node.conditionValue == false) return;
+            if (node.conditionValue == false) {
+                stats_.removedBranches++;
+                return;
+            }
 
-            ASTNode* branch     = node.thenBranch.get();
+            ASTNode* branch     = node.thenBranch;
             std::string comment = "# Static Then Body\n";
             
             auto& mainOutput = getCurrentOutput();
             mainOutput << comment;
             appendBranch(branch);
+            stats_.inlinedBranches++;
     
             return;
         } 
@@ -623,14 +707,14 @@ private:
 
         // then branch
         std::string comment = "# Then Body\n";
-        std::string thenScopeName = generateBranch(node.thenBranch.get(), comment);
+        std::string thenScopeName = generateBranch(node.thenBranch, functionName({ node.thenBranch }, Body::ONLY_THEN), comment);
         
 
         auto& mainOutput = getCurrentOutput();
         // first check to enter the loop
         mainOutput << "# Check condition to enter the 'then' function\n";
 
-        VarInfo conditionVar = *visit(*node.condition);        
+        const VarInfo& conditionVar = *visit(*node.condition);        
         mainOutput << "execute if score " << conditionVar.storagePath << " " << conditionVar.storageIdent << " matches 1 run function " << functionNamespace_ << thenScopeName << "\n";
     
     }
@@ -638,22 +722,28 @@ private:
     void generateWhile(const WhileNode& node) {
         // check if the loop will even start
         // NOTE: if we would want to implement debug mode or debbuger we need to let this pass so the loop body will be generated
-        if (node.isConditionConstant && node.conditionValue == false) return;
+        if (node.isConditionConstant && node.conditionValue == false) {
+            stats_.removedBranches++;
+            return;
+        }
 
         // loop scope
-        enterScope();
-        auto& whileOutput = getCurrentOutput();
-        std::string scopeName = getCurrentScope().name;
+        std::string scopeName = functionName({ &node }, Body::LOOP);
+        if (!keep(scopeName)) {
+            enterScope(node.body, scopeName);
+            auto& whileOutput = getCurrentOutput();
+            scopeName = getCurrentScope().name;
 
-        // loop body
-        whileOutput << "# Loop Body\n";
-        appendBranch(node.body.get());
+            // loop body
+            whileOutput << "# Loop Body\n";
+            appendBranch(node.body);
 
-        // recheck condition at the end of the loop
-        whileOutput << "# Recheck condition at the end of the loop\n";
-        whileOutput << prepareWhileCondition(node, scopeName);
+            // recheck condition at the end of the loop
+            whileOutput << "# Recheck condition at the end of the loop\n";
+            whileOutput << prepareWhileCondition(node, scopeName);
 
-        exitScope();
+            exitScope();
+        }
         
         
         // first check to enter the loop
@@ -671,8 +761,8 @@ private:
             }
         } else {
             // generate condition and then check
-            VarInfo conditionVar = *visit(*node.condition);        
-            return "execute if score " + conditionVar.storagePath + " " + conditionVar.storageIdent + " matches 1 run function " + functionNamespace_ + scopeName + "\n";
+            const VarInfo& conditionVar = *visit(*node.condition);        
+            return "execute if score " + std::string(conditionVar.storagePath.str()) + " " + std::string(conditionVar.storageIdent.str()) + " matches 1 run function " + functionNamespace_ + scopeName + "\n";
         }
         return "";
     }
@@ -681,7 +771,11 @@ private:
 
 
     void generateScope(const ScopeNode& node) {
-        enterScope();
+        // root is always start.mcfunction
+        std::string name = scopeStack_.empty() ? "" : functionName({ &node }, Body::BLOCK);
+        if (keep(name)) return;
+
+        enterScope(&node, name);
                 
         for (const auto& stmt : node.statements) {
             visit(*stmt);
@@ -690,15 +784,141 @@ private:
         exitScope();
     }
 
+
+    // ===== INCREMENTAL =====
+    // -incremental: a function is named after the hash of the nodes it is generated from (+ which kind of body),
+    // so the name changes only when something the function is made of changes. A function that the last build
+    // wrote under the same name is kept as it is and its subtree isn't generated again -> after an edit only the
+    // functions on the path from the edit to the root are written.
+    static constexpr const char* MANIFEST = ".mcjava-functions";
+
+    enum class Body : uint64_t { THEN = 1, ELSE, ONLY_THEN, LOOP, BLOCK };
+
+    // parts = nodes the function is generated from, empty without -incremental -> enterScope keeps the scope_<id> name
+    std::string functionName(std::initializer_list<const ASTNode*> parts, Body body) {
+        if (!hasher_) return "";
+
+        uint64_t h = static_cast<uint64_t>(body);
+        for (const ASTNode* part : parts) {
+            uint64_t partHash = hasher_->hash(*part);
+            h = hashBytes(&partHash, sizeof(partHash), h);
+        }
+
+        char name[19];
+        snprintf(name, sizeof(name), "s_%016llx", (unsigned long long)h);
+        return name;
+    }
+
+    // true if the function (and everything it calls) is taken from the last build,
+    // or was already generated by this one (identical subtrees get the same name)
+    bool keep(const std::string& name) {
+        if (name.empty()) return false;
+        if (functions_.count(name)) {
+            calls_.back().push_back(name);
+            return true;
+        }
+        if (!complete(name)) return false;
+
+        markKept(name);
+        calls_.back().push_back(name);
+        return true;
+    }
+
+    bool complete(const std::string& name) const {
+        auto it = previous_.find(name);
+        std::error_code ec;
+        if (it == previous_.end() || !fs::exists(path_ / (name + ".mcfunction"), ec)) return false;
+
+        for (const auto& callee : it->second) {
+            if (!complete(callee)) return false;
+        }
+        return true;
+    }
+
+    // the subtree isn't visited -> functions it calls have to be carried over from the manifest
+    void markKept(const std::string& name) {
+        const auto& calls = previous_.at(name);
+        if (!functions_.emplace(name, calls).second) return;
+
+        written_.push_back(path_ / (name + ".mcfunction"));
+        stats_.functionsKept++;
+        for (const auto& callee : calls) markKept(callee);
+    }
+
+    // every line but comments & blank ones
+    static size_t countCommands(std::string_view content) {
+        size_t count = 0;
+        for (size_t at = 0; at < content.size();) {
+            size_t end = content.find('\n', at);
+            if (end == std::string_view::npos) end = content.size();
+            size_t first = content.find_first_not_of(" \t", at);
+            if (first < end && content[first] != '#') count++;
+            at = end + 1;
+        }
+        return count;
+    }
+
+    static bool sameContent(const fs::path& path, const std::string& content) {
+        std::error_code ec;
+        if (fs::file_size(path, ec) != content.size() || ec) return false;
+
+        std::ifstream file(path, std::ios::binary);
+        std::string old(content.size(), '\0');
+        return file.read(old.data(), old.size()) && old == content;
+    }
+
+    // one line per function written completely by the last build: <name> <called function>...
+    void loadManifest() {
+        std::ifstream file(path_ / MANIFEST);
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream words(line);
+            std::string name, callee;
+            if (!(words >> name)) continue;
+
+            auto& calls = previous_[name];
+            while (words >> callee) calls.push_back(callee);
+        }
+    }
+
+    // functions of the last build that nothing calls anymore are removed, then the manifest is replaced
+    void finishIncremental() {
+        std::error_code ec;
+        for (const auto& [name, calls] : previous_) {
+            if (!functions_.count(name)) fs::remove(path_ / (name + ".mcfunction"), ec);
+        }
+
+        // removed first, like the functions -> it may be a hard link into the compile cache
+        fs::path manifest = path_ / MANIFEST;
+        fs::remove(manifest, ec);
+
+        // sorted -> the same build always writes (and caches) the same bytes
+        std::vector<const std::pair<const std::string, std::vector<std::string>>*> sorted;
+        sorted.reserve(functions_.size());
+        for (const auto& entry : functions_) sorted.push_back(&entry);
+        std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+
+        std::ofstream file(manifest, std::ios::out);
+        for (const auto* entry : sorted) {
+            file << entry->first;
+            for (const auto& callee : entry->second) file << ' ' << callee;
+            file << "\n";
+        }
+        file.close();
+        written_.push_back(manifest);
+
+        if (!options_.silent) printf("Incremental: %zu functions kept, %zu generated\n", stats_.functionsKept, functions_.size() - stats_.functionsKept);
+    }
+
     
     // ===== SCOREBOARDS MANIPULATION =====
 
     std::string prepareScoreboards() {
         // Collect all unique scoreboard idents
-        std::set<std::string> uniqueIdents;
+        std::set<std::string_view> uniqueIdents; // sorted by text -> same order every run
         for (const auto& scope : allScopes_) {
-            for (const auto& [name, var]: scope->variables) {
-                uniqueIdents.insert(var->storageIdent);
+            for (VarId var : scope->slots) {
+                if (var != NO_VAR) uniqueIdents.insert(vars_[var].storageIdent.str());
             }
         }
         
@@ -712,18 +932,25 @@ private:
 
 private:
     [[noreturn]] void error(const std::string& msg) {
-        std::cerr << "Generation error: " << msg << std::endl;
-        exit(EXIT_FAILURE);
+        throw CompileError("Generation error: " + msg, msg);
     }
 
 };
 
 // ========== WRAPPER ==========
-FunctionGenerator::FunctionGenerator(fs::path& path, Options& options, std::vector<std::shared_ptr<Scope>> scopes)
-    : pImpl(std::make_unique<Impl>(path, options, std::move(scopes))) {}
+FunctionGenerator::FunctionGenerator(fs::path& path, Options& options, std::vector<std::shared_ptr<Scope>> scopes, const Source& source, VarPool& vars)
+    : pImpl(std::make_unique<Impl>(path, options, std::move(scopes), source, vars)) {}
 
 FunctionGenerator::~FunctionGenerator() = default; // Needed for unique_ptr<Impl>
 
 void FunctionGenerator::generate(ASTNode& node) {
     pImpl->generate(node);
+}
+
+const std::vector<fs::path>& FunctionGenerator::files() const {
+    return pImpl->files();
+}
+
+const OptimizationStats& FunctionGenerator::stats() const {
+    return pImpl->stats();
 }
\ No newline at end of file
@@ -12,13 +12,22 @@ namespace fs = std::filesystem;
 
 struct Options;
 struct ASTNode;
+class Source;
+class VarPool;
+struct OptimizationStats;
 
 class FunctionGenerator {
 public:
-    FunctionGenerator(fs::path& path, Options& options, std::vector<std::shared_ptr<Scope>> variables);
+    FunctionGenerator(fs::path& path, Options& options, std::vector<std::shared_ptr<Scope>> variables, const Source& source, VarPool& vars);
     ~FunctionGenerator();
 
     void generate(ASTNode& node);
+
+    // function files written by generate() (empty scopes don't get one)
+    const std::vector<fs::path>& files() const;
+
+    // what generate() left out or emitted (-stats), see core/stats.hpp
+    const OptimizationStats& stats() const;
 private:
     // implematation
     class Impl;
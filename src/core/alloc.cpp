@@ -0,0 +1,23 @@
+// core/alloc.cpp
+// Global operator new / delete -> allocations of every thread are counted for trace::Span (./trace.hpp).
+// Kept in a file of its own, in one that also allocates the compiler warns about the free() below.
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace trace::detail {
+    // constant init -> no guard, safe to touch from operator new
+    constinit thread_local uint64_t allocs = 0;
+    constinit thread_local uint64_t allocBytes = 0;
+}
+
+// array & nothrow forms call these
+void* operator new(std::size_t size) {
+    trace::detail::allocs++;
+    trace::detail::allocBytes += size;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
@@ -0,0 +1,99 @@
+// core/arena.hpp
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for data that lives exactly as long as the compilation unit (AST nodes, child lists, annotations).
+// Allocation is a pointer bump inside big blocks, everything is freed at once when the arena dies.
+// Objects with non trivial destructor are remembered and destroyed (in reverse order) before the blocks are freed.
+class Arena {
+public:
+    Arena() = default;
+    ~Arena() { release(); }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t align) {
+        uintptr_t p = alignUp(reinterpret_cast<uintptr_t>(cur_), align);
+        if (!cur_ || p + size > reinterpret_cast<uintptr_t>(end_)) {
+            grow(size + align);
+            p = alignUp(reinterpret_cast<uintptr_t>(cur_), align);
+        }
+        cur_ = reinterpret_cast<char*>(p + size);
+        used_ += size;
+        return reinterpret_cast<void*>(p);
+    }
+
+    template<typename T, typename... Args>
+    T* make(Args&&... args) {
+        T* obj = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            dtors_.push_back({ obj, [](void* p) { static_cast<T*>(p)->~T(); } });
+        }
+        return obj;
+    }
+
+    // copies [data, data + count) into the arena, used for child lists that were collected in a scratch vector
+    template<typename T>
+    std::span<const T> copy(const T* data, size_t count) {
+        static_assert(std::is_trivially_copyable_v<T>, "Arena::copy only works for trivially copyable types");
+        if (count == 0) return {};
+
+        T* out = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        std::uninitialized_copy(data, data + count, out);
+        return { out, count };
+    }
+
+    // destroys all objects and frees all blocks, the arena can be reused afterwards
+    void release() {
+        for (auto it = dtors_.rbegin(); it != dtors_.rend(); it++) it->fn(it->obj);
+        dtors_.clear();
+        blocks_.clear();
+        cur_ = end_ = nullptr;
+        used_ = reserved_ = 0;
+        nextBlock_ = FIRST_BLOCK;
+    }
+
+    size_t bytesUsed() const { return used_; }
+    size_t bytesReserved() const { return reserved_; }
+
+private:
+    static constexpr size_t FIRST_BLOCK = 64 * 1024;
+    static constexpr size_t MAX_BLOCK   = 4 * 1024 * 1024;
+
+    struct Dtor {
+        void* obj;
+        void (*fn)(void*);
+    };
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    std::vector<Dtor> dtors_;
+    char* cur_ = nullptr;
+    char* end_ = nullptr;
+
+    size_t used_ = 0;
+    size_t reserved_ = 0;
+    size_t nextBlock_ = FIRST_BLOCK;
+
+    static uintptr_t alignUp(uintptr_t p, size_t align) {
+        return (p + align - 1) & ~static_cast<uintptr_t>(align - 1);
+    }
+
+    // blocks double in size (up to MAX_BLOCK) so big inputs need only a few of them
+    void grow(size_t atLeast) {
+        size_t size = nextBlock_ > atLeast ? nextBlock_ : atLeast;
+        if (nextBlock_ < MAX_BLOCK) nextBlock_ *= 2;
+
+        blocks_.push_back(std::make_unique_for_overwrite<char[]>(size));
+        cur_ = blocks_.back().get();
+        end_ = cur_ + size;
+        reserved_ += size;
+    }
+};
@@ -2,35 +2,65 @@
 #pragma once
 
 #include <string>
-#include <vector>
+#include <string_view>
+#include <span>
 #include <memory>
+#include <cstdint>
 
 #include "./token.hpp"
-#include "./varInfo.hpp"
-#include "./visitor.hpp"
+#include "./varPool.hpp"
 
 
 struct Annotation {
-    std::string name;
+    std::string_view name; // points into Source
     // in the future -> annotation arguments -> @Annotation(type = "special") or something similar
 };
 
 
+// Nodes, child lists and annotation lists are allocated in the Arena of the compilation unit (see ./arena.hpp)
+// -> nodes only point to each other, nothing here owns memory
+class ASTNode;
+using NodeList = std::span<ASTNode* const>;
+
+
+// where a variable lives -> slot in the flat slot array of the scope that declared it
+// filled once by the Resolver (see ./../middleend/resolver.hpp), later phases never look a name up again
+struct Binding {
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    uint32_t scope = NONE;  // ScopeNode::scopeId of the declaring scope (= index in the analyzer's scope list)
+    uint32_t slot  = NONE;
+
+    bool resolved() const { return scope != NONE; }
+};
+
+
+// every node carries its kind -> dispatch is a switch (see ./visitor.hpp) and downcasts are a tag compare
+enum class NodeKind : uint8_t {
+    COMMAND, VAR_DECL, EXPR, BINARY_OP, IF, WHILE, SCOPE
+};
+
+
 // ========== CLASSES ==========
+// no virtual methods -> nodes are never deleted through ASTNode*, the arena destroys them by their real type
 class ASTNode {
 public:
-    virtual ~ASTNode() = default;
-    virtual ASTReturn accept(ASTVisitor& visitor) const = 0;
+    const NodeKind kind;
 
+    // replacement for dynamic_cast, nullptr if the node is of a different kind
     template<typename T>
-    T visit(ASTVisitor& visitor) const {
-        return std::get<T>(this->accept(visitor));
-    }
+    T* as() { return kind == T::KIND ? static_cast<T*>(this) : nullptr; }
+
+    template<typename T>
+    const T* as() const { return kind == T::KIND ? static_cast<const T*>(this) : nullptr; }
 
     
     // --- Semantic Data ---
     mutable bool isAnalyzed = false;
-    std::vector<Annotation> annotations = {};
+    std::span<const Annotation> annotations = {};
+
+protected:
+    explicit ASTNode(NodeKind kind) : kind(kind) {}
 };
 
 
@@ -39,110 +69,104 @@ public:
 
 class CommandNode : public ASTNode {
 public:
+    static constexpr NodeKind KIND = NodeKind::COMMAND;
+
     Token command;
-    std::vector<std::unique_ptr<ASTNode>> args;
+    NodeList args;      // say -> expressions
+    Token text;         // every other command -> raw arguments (COMMAND_TEXT, length 0 if there are none)
     
-    CommandNode(Token cmd, std::vector<std::unique_ptr<ASTNode>> args = {})
-        : command(cmd), args(std::move(args)) {}
-
-    ASTReturn accept(ASTVisitor& visitor) const override {
-        return visitor.visitCommand(*this);
-    }
+    CommandNode(Token cmd, NodeList args = {}, Token text = {})
+        : ASTNode(KIND), command(cmd), args(args), text(text) {}
 };
 
 
 class VarDeclNode : public ASTNode {
 public:
+    static constexpr NodeKind KIND = NodeKind::VAR_DECL;
+
     Token name;
-    std::unique_ptr<ASTNode> value;
+    SymbolId symbol;    // interned name
+    ASTNode* value;
  
-    mutable std::shared_ptr<VarInfo> varInfo;
+    mutable Binding binding;
+    mutable VarId varId = NO_VAR;  // semantic data in the unit's VarPool
     
-    VarDeclNode(Token name, std::unique_ptr<ASTNode> value)
-        : name(name), value(std::move(value)) {}
-
-    ASTReturn accept(ASTVisitor& visitor) const override {
-        return visitor.visitVarDecl(*this);
-    }
+    VarDeclNode(Token name, SymbolId symbol, ASTNode* value)
+        : ASTNode(KIND), name(name), symbol(symbol), value(value) {}
 };
 
 
 class ExprNode : public ASTNode {
 public:
+    static constexpr NodeKind KIND = NodeKind::EXPR;
+
     Token token;
+    SymbolId symbol;    // interned name, only for IDENT
     
     mutable bool forceDynamic = false;
-    mutable std::shared_ptr<VarInfo> varInfo;
+    mutable Binding binding;    // only for IDENT, unresolved if the variable was never assigned
+    mutable VarId varId = NO_VAR;  // semantic data in the unit's VarPool
     
-    ExprNode(Token token)
-        : token(token) {}
-    
-    ASTReturn accept(ASTVisitor& visitor) const override {
-        return visitor.visitExpr(*this);
-    }
+    ExprNode(Token token, SymbolId symbol = {})
+        : ASTNode(KIND), token(token), symbol(symbol) {}
 };
 
 
 class BinaryOpNode : public ASTNode {
 public:
+    static constexpr NodeKind KIND = NodeKind::BINARY_OP;
+
     Token op;
-    std::unique_ptr<ASTNode> left;
-    std::unique_ptr<ASTNode> right;
+    ASTNode* left;
+    ASTNode* right;
 
-    mutable std::shared_ptr<VarInfo> varInfo;
-    
-    BinaryOpNode(Token op, std::unique_ptr<ASTNode> left, std::unique_ptr<ASTNode> right)
-        : op(op), left(std::move(left)), right(std::move(right)) {}
+    mutable VarId varId = NO_VAR;  // semantic data in the unit's VarPool
     
-    ASTReturn accept(ASTVisitor& visitor) const override {
-        return visitor.visitBinaryOp(*this);
-    }
+    BinaryOpNode(Token op, ASTNode* left, ASTNode* right)
+        : ASTNode(KIND), op(op), left(left), right(right) {}
 };
 
 
 class IfNode : public ASTNode {
 public:
-    std::unique_ptr<ASTNode> condition;
-    std::unique_ptr<ASTNode> thenBranch;
-    std::unique_ptr<ASTNode> elseBranch;  // can be nullptr
+    static constexpr NodeKind KIND = NodeKind::IF;
+
+    ASTNode* condition;
+    ASTNode* thenBranch;
+    ASTNode* elseBranch;  // can be nullptr
 
     mutable bool isConditionConstant = false;
     mutable bool conditionValue = false;
     
-    IfNode(std::unique_ptr<ASTNode> condition, std::unique_ptr<ASTNode> thenBranch, std::unique_ptr<ASTNode> elseBranch)
-        : condition(std::move(condition)), thenBranch(std::move(thenBranch)), elseBranch(std::move(elseBranch)) {}
-    
-    ASTReturn accept(ASTVisitor& visitor) const override {
-        return visitor.visitIf(*this);
-    }
+    IfNode(ASTNode* condition, ASTNode* thenBranch, ASTNode* elseBranch)
+        : ASTNode(KIND), condition(condition), thenBranch(thenBranch), elseBranch(elseBranch) {}
 };
 
 
 class WhileNode : public ASTNode {
 public:
-    std::unique_ptr<ASTNode> condition;
-    std::unique_ptr<ASTNode> body;
+    static constexpr NodeKind KIND = NodeKind::WHILE;
+
+    ASTNode* condition;
+    ASTNode* body;
 
     mutable bool isConditionConstant = false;
     mutable bool conditionValue = false;
     
-    WhileNode(std::unique_ptr<ASTNode> condition, std::unique_ptr<ASTNode> body)
-        : condition(std::move(condition)), body(std::move(body)) {}
-    
-    ASTReturn accept(ASTVisitor& visitor) const override {
-        return visitor.visitWhile(*this);
-    }
+    WhileNode(ASTNode* condition, ASTNode* body)
+        : ASTNode(KIND), condition(condition), body(body) {}
 };
 
 
 class ScopeNode : public ASTNode {
 public:
-    std::vector<std::unique_ptr<ASTNode>> statements;
-    
-    ScopeNode(std::vector<std::unique_ptr<ASTNode>> statements = {})
-        : statements(std::move(statements)) {}
+    static constexpr NodeKind KIND = NodeKind::SCOPE;
+
+    NodeList statements;
+
+    mutable uint32_t scopeId   = 0; // preorder index of the scope
+    mutable uint32_t slotCount = 0; // number of variables declared directly in this scope
     
-    ASTReturn accept(ASTVisitor& visitor) const override {
-        return visitor.visitScope(*this);
-    }
+    ScopeNode(NodeList statements = {})
+        : ASTNode(KIND), statements(statements) {}
 };
\ No newline at end of file
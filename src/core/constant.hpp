@@ -0,0 +1,70 @@
+// core/constant.hpp
+#pragma once
+
+#include <cstdint>
+#include <charconv>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Value of a constant known at compile time.
+// INT and BOOL are stored as numbers so folding never goes through strings, FLOAT and STRING keep their
+// text as written (floats are never folded, nothing in minecraft can store them in a scoreboard).
+// Text points into the Source -> copying a Constant never allocates.
+struct Constant {
+    enum class Kind : uint8_t { NONE, INT, BOOL, FLOAT, STRING };
+
+    Kind kind = Kind::NONE;
+    int32_t value = 0;          // INT, BOOL (0 / 1)
+    std::string_view text = {}; // FLOAT, STRING
+
+    static Constant ofInt(int32_t v)             { return { .kind = Kind::INT,  .value = v }; }
+    static Constant ofBool(bool v)               { return { .kind = Kind::BOOL, .value = v ? 1 : 0 }; }
+    static Constant ofFloat(std::string_view t)  { return { .kind = Kind::FLOAT,  .text = t }; }
+    static Constant ofString(std::string_view t) { return { .kind = Kind::STRING, .text = t }; }
+
+    // parses INT_LIT, false if it doesn't fit into int32 (scoreboards are 32-bit)
+    static bool parseInt(std::string_view text, Constant& out) {
+        int32_t v;
+        auto res = std::from_chars(text.data(), text.data() + text.size(), v);
+        if (res.ec != std::errc() || res.ptr != text.data() + text.size()) return false;
+        out = ofInt(v);
+        return true;
+    }
+
+    bool empty() const { return kind == Kind::NONE; }
+    bool isNumeric() const { return kind == Kind::INT || kind == Kind::BOOL; }
+
+    // conditions accept only 0 / 1
+    bool isBoolLike() const { return isNumeric() && (value == 0 || value == 1); }
+
+    // printed exactly like it is emitted into commands
+    friend std::ostream& operator<<(std::ostream& os, const Constant& c) {
+        if (c.isNumeric()) return os << c.value;
+        return os << c.text;
+    }
+
+    std::string toString() const {
+        if (isNumeric()) return std::to_string(value);
+        return std::string(text);
+    }
+};
+
+
+// ===== FOLDING =====
+// Same results as scoreboard operations in game -> 32-bit two's complement wraparound,
+// division is rounded down (floorDiv), INT_MIN / -1 stays INT_MIN.
+namespace fold {
+
+    inline int32_t add(int32_t a, int32_t b) { return static_cast<int32_t>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b)); }
+    inline int32_t sub(int32_t a, int32_t b) { return static_cast<int32_t>(static_cast<uint32_t>(a) - static_cast<uint32_t>(b)); }
+    inline int32_t mul(int32_t a, int32_t b) { return static_cast<int32_t>(static_cast<uint32_t>(a) * static_cast<uint32_t>(b)); }
+
+    // b != 0 is checked by the analyzer
+    inline int32_t div(int32_t a, int32_t b) {
+        if (a == INT32_MIN && b == -1) return INT32_MIN;
+        int32_t q = a / b;
+        if ((a % b != 0) && ((a < 0) != (b < 0))) q--;
+        return q;
+    }
+}
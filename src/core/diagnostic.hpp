@@ -0,0 +1,22 @@
+// core/diagnostic.hpp
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+// Error of any compiler phase. Thrown instead of exiting -> the command line prints what() and stops,
+// project mode fails only the one file and the language server turns it into a diagnostic (see lsp/document.hpp).
+class CompileError : public std::runtime_error {
+public:
+    static constexpr uint32_t NO_OFFSET = UINT32_MAX;
+
+    // text is printed by the command line as it is ("Parser error: ... at line 3, column 7"),
+    // message is the same without the phase & position for editors
+    CompileError(const std::string& text, std::string message, uint32_t offset = NO_OFFSET, uint32_t length = 0)
+        : std::runtime_error(text), message(std::move(message)), offset(offset), length(length) {}
+
+    std::string message;
+    uint32_t offset;    // where in the source, NO_OFFSET if the phase doesn't know (generator, some analyzer errors)
+    uint32_t length;
+};
@@ -0,0 +1,38 @@
+// core/hash.hpp
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Fast 64-bit content hash (not cryptographic) -> used to check if cached data still matches its input.
+// Reads 8 bytes per step, a few hundred KB are hashed in well under a millisecond.
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0) {
+    constexpr uint64_t K = 0x9E3779B97F4A7C15ull;
+
+    auto mix = [](uint64_t h) {
+        h ^= h >> 33; h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33; h *= 0xC4CEB9FE1A85EC53ull;
+        h ^= h >> 33;
+        return h;
+    };
+
+    const char* p = static_cast<const char*>(data);
+    uint64_t h = seed ^ (size * K);
+
+    for (; size >= 8; p += 8, size -= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        h = (h ^ mix(word * K)) * K + 0x632BE59BD9B4E019ull;
+    }
+
+    uint64_t tail = 0;
+    if (size) std::memcpy(&tail, p, size); // p may be null for an empty string_view
+    h = (h ^ mix(tail * K + size)) * K;
+
+    return mix(h);
+}
+
+inline uint64_t hashBytes(std::string_view text, uint64_t seed = 0) {
+    return hashBytes(text.data(), text.size(), seed);
+}
@@ -0,0 +1,40 @@
+// core/interner.cpp
+#include "./interner.hpp"
+
+#include <iostream>
+
+Interner& Interner::global() {
+    static Interner instance;
+    return instance;
+}
+
+Interner::Interner() {
+    intern(""); // id 0
+}
+
+SymbolId Interner::intern(std::string_view text) {
+    std::lock_guard lock(mutex_);
+
+    auto it = index_.find(text);
+    if (it != index_.end()) return { it->second };
+
+    if (count_ == PAGE_SIZE * MAX_PAGES) {
+        std::cerr << "Too many symbols" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    uint32_t id = count_++;
+    auto& page = pages_[id / PAGE_SIZE];
+    if (!page) page = std::make_unique<std::string_view[]>(PAGE_SIZE);
+
+    std::span<const char> stored = chars_.copy(text.data(), text.size());
+    std::string_view key(stored.data(), stored.size());
+    page[id % PAGE_SIZE] = key;
+    index_.emplace(key, id);
+    return { id };
+}
+
+size_t Interner::size() const {
+    std::lock_guard lock(mutex_);
+    return count_;
+}
@@ -0,0 +1,63 @@
+// core/interner.hpp
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <unordered_map>
+
+#include "./arena.hpp"
+
+// Interned string -> every identifier, temp name and objective name is a 32-bit id.
+// Comparing & hashing ids is free, the text is only needed when something is emitted.
+struct SymbolId {
+    uint32_t id = 0; // 0 is always the empty string
+
+    std::string_view str() const;
+    bool empty() const { return id == 0; }
+
+    friend bool operator==(SymbolId a, SymbolId b) { return a.id == b.id; }
+    friend std::ostream& operator<<(std::ostream& os, SymbolId s) { return os << s.str(); }
+};
+
+template<>
+struct std::hash<SymbolId> {
+    size_t operator()(SymbolId s) const noexcept { return s.id; }
+};
+
+
+// Process wide table of interned strings. Strings are never removed so every string_view handed out stays valid.
+// intern() takes a lock (project mode interns from many threads), reading the text of an id is lock free:
+// texts live in fixed pages that are never moved and a page is filled in before any id pointing into it is returned.
+class Interner {
+public:
+    static Interner& global();
+
+    SymbolId intern(std::string_view text);
+    std::string_view str(SymbolId sym) const {
+        return pages_[sym.id / PAGE_SIZE][sym.id % PAGE_SIZE];
+    }
+
+    size_t size() const;
+
+private:
+    Interner();
+
+    static constexpr size_t PAGE_SIZE = 4096;
+    static constexpr size_t MAX_PAGES = 16384; // 64M symbols
+
+    mutable std::mutex mutex_;
+    Arena chars_;                                           // text of all symbols
+    std::unordered_map<std::string_view, uint32_t> index_;  // text -> id, keys point into chars_
+    std::array<std::unique_ptr<std::string_view[]>, MAX_PAGES> pages_;
+    uint32_t count_ = 0;
+};
+
+inline std::string_view SymbolId::str() const { return Interner::global().str(*this); }
+
+// shorthand used all over analyzer & generator
+inline SymbolId intern(std::string_view text) { return Interner::global().intern(text); }
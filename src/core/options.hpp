@@ -15,6 +15,7 @@ struct Options {
 
     bool doConstantFolding  = true;
     bool removeUnusedVars   = true;
+    bool incremental        = false; // functions named by the hash of their subtree, unchanged ones are kept from the last build
     
     //bool optimizeUniqueVars = true; // tries to reuse allocated vars as much as possible -> idk if this will gain any performace, its just an idea
     
@@ -25,4 +26,20 @@ struct Options {
     std::string mcdocPath  = "./mcdoc/commands.json";
     std::string dpPrefix   = "mcjava";
     std::string dpPath     = "";
+
+    // Compile cache
+    std::string cacheDir   = "";    // empty -> no cache
+    bool cacheStats        = false;
+
+    // Project mode (input is a directory)
+    size_t threads         = 0;     // 0 -> one per hardware thread
+    std::string outPath    = "";    // default: <source root>-out
+
+    // Daemon mode (driver/daemon.hpp)
+    bool daemon            = false; // stay up, recompile the input whenever it changes
+
+    // Instrumentation (core/trace.hpp)
+    std::string tracePath  = "";    // empty -> no trace, the summary goes next to it (<name>.summary.json)
+    bool stats             = false; // optimization report (core/stats.hpp), needs a real build -> the cache is skipped
+    std::string statsPath  = "";    // -stats=<file>: the report as JSON
 };
\ No newline at end of file
@@ -0,0 +1,53 @@
+// core/source.cpp
+#include "./source.hpp"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Source::~Source() {
+    if (mapped_) munmap(mapped_, mappedSize_);
+}
+
+bool Source::loadFromFile(const std::string& path, std::string* err) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        if (err) *err = "Cannot open file: " + path + " (" + std::strerror(errno) + ")";
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            madvise(data, st.st_size, MADV_SEQUENTIAL); // tokenizer reads it front to back exactly once
+
+            mapped_     = data;
+            mappedSize_ = st.st_size;
+            text_       = std::string_view(static_cast<const char*>(data), mappedSize_);
+            close(fd);
+            return true;
+        }
+    }
+
+    // fallback: pipes, character devices, empty files or failed mmap
+    owned_.clear();
+    char chunk[64 * 1024];
+    while (true) {
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n == 0) break;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (err) *err = "Cannot read file: " + path + " (" + std::strerror(errno) + ")";
+            close(fd);
+            return false;
+        }
+        owned_.append(chunk, n);
+    }
+    close(fd);
+
+    text_ = owned_;
+    return true;
+}
@@ -0,0 +1,91 @@
+// core/source.hpp
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include "./token.hpp"
+
+struct SourcePos {
+    size_t line;    // 1-based
+    size_t col;     // 0-based, same as the tokenizer always reported
+};
+
+// Owns the program text for the whole compilation, tokens only point into it.
+// The text is either memory mapped straight from the file (loadFromFile) or an owned string.
+// Text that doesn't exist in the file (decoded escape sequences, tokens made up by the parser)
+// lives in the synthetic area which starts right after the source (+1 so a token at the very end of
+// the text is still a real position), so one 32-bit offset covers both.
+class Source {
+public:
+    Source() = default;
+    explicit Source(std::string text) : owned_(std::move(text)), text_(owned_) {}
+    ~Source(); // unmaps the file, implemented in ./source.cpp
+
+    Source(const Source&) = delete;
+    Source& operator=(const Source&) = delete;
+
+    // maps the file into memory, falls back to read() for pipes and other non regular files (e.g. /dev/stdin)
+    // the text is NOT normalized -> CRLF is handled by the tokenizer
+    bool loadFromFile(const std::string& path, std::string* err = nullptr);
+
+    static constexpr size_t MAX_SIZE = UINT32_MAX / 2; // the other half of the offset space is for the synthetic area
+
+    std::string_view text() const { return text_; }
+    size_t size() const { return text_.size(); }
+
+    std::string_view lexeme(const Token& token) const {
+        if (isSynthetic(token.offset)) {
+            return std::string_view(synthetic_).substr(token.offset - text_.size() - 1, token.length);
+        }
+        return std::string_view(text_).substr(token.offset, token.length);
+    }
+
+    // appends text to the synthetic area and returns token pointing at it
+    Token synthesize(TokenType type, std::string_view value) {
+        Token token = { .type = type, .offset = static_cast<uint32_t>(text_.size() + 1 + synthetic_.size()), .length = static_cast<uint32_t>(value.size()) };
+        synthetic_.append(value);
+        return token;
+    }
+
+    bool isSynthetic(uint32_t offset) const { return offset > text_.size(); }
+
+    // line & column are recovered only when needed (diagnostics), line table is built on the first call
+    SourcePos position(uint32_t offset) const {
+        if (isSynthetic(offset)) return { 0, 0 };
+
+        if (lineStarts_.empty()) buildLineTable();
+
+        // last line start that is <= offset
+        auto it = std::upper_bound(lineStarts_.begin(), lineStarts_.end(), offset);
+        size_t lineIdx = (it - lineStarts_.begin()) - 1;
+        return { lineIdx + 1, offset - lineStarts_[lineIdx] };
+    }
+
+    SourcePos position(const Token& token) const { return position(token.offset); }
+
+private:
+    std::string owned_;
+    void* mapped_ = nullptr;
+    size_t mappedSize_ = 0;
+
+    std::string_view text_;
+    std::string synthetic_;
+    mutable std::vector<uint32_t> lineStarts_;
+
+    void buildLineTable() const {
+        lineStarts_.push_back(0);
+        const char* begin = text_.data();
+        const char* end   = begin + text_.size();
+        for (const char* p = begin; p < end; p++) {
+            const void* nl = std::memchr(p, '\n', end - p);
+            if (!nl) break;
+            p = static_cast<const char*>(nl);
+            lineStarts_.push_back(static_cast<uint32_t>(p - begin) + 1);
+        }
+    }
+};
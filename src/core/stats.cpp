@@ -0,0 +1,63 @@
+// core/stats.cpp
+#include "./stats.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+#include "./../../libs/json.hpp"
+
+void OptimizationStats::add(const OptimizationStats& other) {
+    foldedNodes      += other.foldedNodes;
+    staticConditions += other.staticConditions;
+    tempsAllocated   += other.tempsAllocated;
+    eliminatedVars   += other.eliminatedVars;
+    removedBranches  += other.removedBranches;
+    inlinedBranches  += other.inlinedBranches;
+    functionsEmitted += other.functionsEmitted;
+    functionsSkipped += other.functionsSkipped;
+    functionsKept    += other.functionsKept;
+    commands.insert(commands.end(), other.commands.begin(), other.commands.end());
+}
+
+size_t OptimizationStats::totalCommands() const {
+    size_t total = 0;
+    for (const auto& [name, count] : commands) total += count;
+    return total;
+}
+
+std::string OptimizationStats::text() const {
+    std::ostringstream out;
+    out << "Optimization stats:\n";
+    out << "  folded nodes:       " << foldedNodes << "\n";
+    out << "  static conditions:  " << staticConditions << "\n";
+    out << "  temps allocated:    " << tempsAllocated << "\n";
+    out << "  eliminated vars:    " << eliminatedVars << "\n";
+    out << "  removed branches:   " << removedBranches << "\n";
+    out << "  inlined branches:   " << inlinedBranches << "\n";
+    out << "  functions:          " << functionsEmitted << " emitted, " << functionsSkipped << " skipped (empty), " << functionsKept << " kept\n";
+    out << "  commands:           " << totalCommands() << "\n";
+
+    size_t width = 0;
+    for (const auto& [name, count] : commands) width = std::max(width, name.size());
+    for (const auto& [name, count] : commands) {
+        out << "    " << name << std::string(width - name.size() + 2, ' ') << count << "\n";
+    }
+    return out.str();
+}
+
+std::string OptimizationStats::json() const {
+    nlohmann::ordered_json perFunction = nlohmann::ordered_json::object();
+    for (const auto& [name, count] : commands) perFunction[name] = count;
+
+    nlohmann::ordered_json out = {
+        { "folded_nodes", foldedNodes },
+        { "static_conditions", staticConditions },
+        { "temps_allocated", tempsAllocated },
+        { "eliminated_vars", eliminatedVars },
+        { "removed_branches", removedBranches },
+        { "inlined_branches", inlinedBranches },
+        { "functions", { { "emitted", functionsEmitted }, { "skipped", functionsSkipped }, { "kept", functionsKept } } },
+        { "commands", { { "total", totalCommands() }, { "per_function", std::move(perFunction) } } },
+    };
+    return out.dump(1, '\t') + "\n";
+}
@@ -0,0 +1,33 @@
+// core/stats.hpp
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// What the optimizer did in one build (-stats). The analyzer and the generator count their part, main (or the
+// project, one per file) adds them up and prints the report. Only generated code is counted -> with -incremental
+// the functions kept from the last build are in functionsKept, nothing else.
+struct OptimizationStats {
+    // analyzer
+    size_t foldedNodes      = 0;    // binary operations replaced by their constant value
+    size_t staticConditions = 0;    // if / while conditions known at compile time
+    size_t tempsAllocated   = 0;    // scores holding the result of a dynamic expression
+
+    // generator
+    size_t eliminatedVars   = 0;    // declarations that emit nothing (unused, or constant and inlined where used)
+    size_t removedBranches  = 0;    // if branches / loops a static condition never runs
+    size_t inlinedBranches  = 0;    // branches a static condition always runs -> generated into the enclosing function
+    size_t functionsEmitted = 0;
+    size_t functionsSkipped = 0;    // empty scopes, no file
+    size_t functionsKept    = 0;    // -incremental
+
+    std::vector<std::pair<std::string, size_t>> commands; // function (as it's called) -> commands in it, in generation order
+
+    void add(const OptimizationStats& other);
+
+    size_t totalCommands() const;
+    std::string text() const;
+    std::string json() const;
+};
@@ -0,0 +1,84 @@
+// core/threadPool.cpp
+#include "./threadPool.hpp"
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 0; i < threads; i++) queues_.push_back(std::make_unique<Queue>());
+    for (size_t i = 0; i < threads; i++) threads_.emplace_back([this, i] { run(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    work_.notify_all();
+    for (auto& thread : threads_) thread.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    size_t target;
+    {
+        std::lock_guard lock(mutex_);
+        target = next_++ % queues_.size();
+        pending_++;
+    }
+    {
+        std::lock_guard lock(queues_[target]->mutex);
+        queues_[target]->tasks.push_back(std::move(task));
+        queued_++;
+    }
+    // taken under mutex_ -> a worker can't miss it between checking queued_ and going to sleep
+    { std::lock_guard lock(mutex_); }
+    work_.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock lock(mutex_);
+    done_.wait(lock, [this] { return pending_ == 0; });
+}
+
+// own deque first (newest task, still warm), then the oldest task of the others
+bool ThreadPool::take(size_t self, std::function<void()>& task) {
+    {
+        Queue& own = *queues_[self];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued_--;
+            return true;
+        }
+    }
+    for (size_t i = 1; i < queues_.size(); i++) {
+        Queue& other = *queues_[(self + i) % queues_.size()];
+        std::lock_guard lock(other.mutex);
+        if (!other.tasks.empty()) {
+            task = std::move(other.tasks.front());
+            other.tasks.pop_front();
+            queued_--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(size_t self) {
+    std::function<void()> task;
+    while (true) {
+        if (take(self, task)) {
+            task();
+            task = nullptr;
+
+            std::lock_guard lock(mutex_);
+            if (--pending_ == 0) done_.notify_all();
+            continue;
+        }
+
+        std::unique_lock lock(mutex_);
+        work_.wait(lock, [this] { return stop_ || queued_ > 0; });
+        if (stop_ && queued_ == 0) return;
+    }
+}
@@ -0,0 +1,52 @@
+// core/threadPool.hpp
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of workers, each with its own task deque. A worker takes tasks from the back of its own deque
+// and when it runs dry steals from the front of the others -> one worker stuck on a big file doesn't hold
+// back the small files that were queued behind it.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads); // 0 -> one per hardware thread
+    ~ThreadPool(); // waits for the queued tasks, implemented in ./threadPool.cpp
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // tasks are dealt round robin, safe to call from a running task
+    void submit(std::function<void()> task);
+
+    // blocks until every submitted task has finished
+    void wait();
+
+    size_t size() const { return threads_.size(); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;              // guards sleeping & finishing, the queues have their own locks
+    std::condition_variable work_;
+    std::condition_variable done_;
+    std::atomic<size_t> queued_ = 0;
+    size_t pending_ = 0;            // submitted and not finished yet
+    size_t next_ = 0;
+    bool stop_ = false;
+
+    bool take(size_t self, std::function<void()>& task);
+    void run(size_t self);
+};
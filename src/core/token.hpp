@@ -2,7 +2,7 @@
 #pragma once
 
 #include <string>
-#include <optional>
+#include <cstdint>
 
 enum class TokenType {
     // Literals
@@ -26,6 +26,7 @@ enum class TokenType {
     
     // Dynamic
     IDENT, CMD_KEY, ANNOTATION,
+    COMMAND_TEXT,   // raw arguments of a minecraft command (rest of the line)
     
     // Special
     NEW_LINE, END_OF_FILE,
@@ -78,6 +79,7 @@ const inline std::string tokenTypeToString(const TokenType type) {
         case TokenType::IDENT       : return "IDENTIFIER";
         case TokenType::CMD_KEY     : return "COMMAND_KEY";
         case TokenType::ANNOTATION  : return "ANNOTATION";
+        case TokenType::COMMAND_TEXT: return "COMMAND_TEXT";
         
         // Special
         case TokenType::NEW_LINE    : return "NEW_LINE";
@@ -86,9 +88,28 @@ const inline std::string tokenTypeToString(const TokenType type) {
     }
 }
 
+// Keywords and special tokens are fully described by their type, the rest carries a value (lexeme)
+inline bool tokenHasValue(const TokenType type) {
+    switch (type) {
+        case TokenType::WHILE:
+        case TokenType::FOR:
+        case TokenType::IF:
+        case TokenType::ELSE:
+        case TokenType::RETURN:
+        case TokenType::TRUE:
+        case TokenType::FALSE:
+        case TokenType::NEW_LINE:
+        case TokenType::END_OF_FILE:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// Compact token -> only a view (offset + length) into the Source buffer (./source.hpp)
+// the text is resolved with Source::lexeme and line/column with Source::position
 struct Token {
-    TokenType type;
-    std::optional<std::string> value {};
-    size_t line;
-    size_t col;
+    TokenType type = TokenType::END_OF_FILE;
+    uint32_t offset = 0;
+    uint32_t length = 0;
 };
\ No newline at end of file
@@ -0,0 +1,176 @@
+// core/trace.cpp
+#include "./trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "./version.hpp"
+#include "./../../libs/json.hpp"
+
+// allocations of the current thread, counted in ./alloc.cpp
+namespace trace::detail {
+    extern constinit thread_local uint64_t allocs;
+    extern constinit thread_local uint64_t allocBytes;
+}
+
+namespace {
+
+    const auto epoch = std::chrono::steady_clock::now();
+
+    uint64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    uint64_t cpuNs(clockid_t clock) {
+        timespec ts;
+        clock_gettime(clock, &ts);
+        return uint64_t(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+    }
+
+    trace::Counters threadTotals() {
+        return { nowNs(), cpuNs(CLOCK_THREAD_CPUTIME_ID), trace::detail::allocs, trace::detail::allocBytes };
+    }
+
+    struct Event {
+        const char* name;
+        std::string detail;
+        uint32_t tid;
+        uint64_t startNs;
+        trace::Counters counters;
+    };
+
+    std::atomic<bool> recording = false;
+    uint64_t enabledAt = 0;
+    std::mutex mutex;           // guards events
+    std::vector<Event> events;
+
+    uint32_t threadId() {
+        thread_local uint32_t tid = uint32_t(syscall(SYS_gettid)); // the main thread's is the pid -> shown as main
+        return tid;
+    }
+}
+
+namespace trace {
+
+    Span::Span(const char* name, std::string_view detail) : name_(name) {
+        if (recording) detail_ = detail;
+        start_ = threadTotals();
+        startNs_ = start_.wallNs;
+    }
+
+    Counters Span::end() {
+        if (ended_) return start_;
+        ended_ = true;
+
+        Counters now = threadTotals();
+        start_ = { now.wallNs - start_.wallNs, now.cpuNs - start_.cpuNs, now.allocs - start_.allocs, now.allocBytes - start_.allocBytes };
+
+        if (recording) {
+            Event event = { name_, std::move(detail_), threadId(), startNs_, start_ };
+            std::lock_guard lock(mutex);
+            events.push_back(std::move(event));
+        }
+        return start_;
+    }
+
+    void enable() {
+        enabledAt = nowNs();
+        recording = true;
+    }
+
+    bool enabled() {
+        return recording;
+    }
+
+    uint64_t peakRssBytes() {
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return uint64_t(usage.ru_maxrss) * 1024; // KB on Linux
+    }
+
+    bool write(const std::string& path, std::string* err) {
+        using json = nlohmann::ordered_json;
+
+        std::vector<Event> sorted;
+        {
+            std::lock_guard lock(mutex);
+            sorted = events;
+        }
+        // parents before their children, also when both started in the same ns
+        std::sort(sorted.begin(), sorted.end(), [](const Event& a, const Event& b) {
+            return a.startNs != b.startNs ? a.startNs < b.startNs : a.counters.wallNs > b.counters.wallNs;
+        });
+
+        // self time -> wall time minus the spans nested directly in it (same thread)
+        std::vector<uint64_t> selfNs(sorted.size());
+        std::vector<std::pair<uint32_t, std::vector<size_t>>> open; // thread -> spans it is inside of
+        for (size_t i = 0; i < sorted.size(); i++) {
+            const Event& e = sorted[i];
+            selfNs[i] = e.counters.wallNs;
+
+            auto it = std::find_if(open.begin(), open.end(), [&](const auto& t) { return t.first == e.tid; });
+            if (it == open.end()) it = open.insert(open.end(), { e.tid, {} });
+            std::vector<size_t>& stack = it->second;
+            while (!stack.empty() && sorted[stack.back()].startNs + sorted[stack.back()].counters.wallNs <= e.startNs) stack.pop_back();
+            if (!stack.empty()) selfNs[stack.back()] -= std::min(selfNs[stack.back()], e.counters.wallNs);
+            stack.push_back(i);
+        }
+
+        // Chrome trace -> complete events (ph X), times in us
+        json traceEvents = json::array();
+        for (const Event& e : sorted) {
+            json args = { { "cpu_ns", e.counters.cpuNs }, { "allocs", e.counters.allocs }, { "alloc_bytes", e.counters.allocBytes } };
+            if (!e.detail.empty()) args["detail"] = e.detail;
+
+            traceEvents.push_back({
+                { "name", e.name }, { "cat", "mcjava" }, { "ph", "X" },
+                { "ts", e.startNs / 1000.0 }, { "dur", e.counters.wallNs / 1000.0 },
+                { "pid", getpid() }, { "tid", e.tid }, { "args", std::move(args) },
+            });
+        }
+
+        // summary -> totals per span name, in order of the first start
+        // all of them inclusive (a function nested in a function counts twice) except self_ns
+        json spans = json::object();
+        for (size_t i = 0; i < sorted.size(); i++) {
+            const Event& e = sorted[i];
+            json& s = spans[e.name];
+            if (s.is_null()) s = { { "count", 0 }, { "wall_ns", 0 }, { "self_ns", 0 }, { "cpu_ns", 0 }, { "allocs", 0 }, { "alloc_bytes", 0 } };
+            s["count"]       = s["count"].get<uint64_t>() + 1;
+            s["wall_ns"]     = s["wall_ns"].get<uint64_t>() + e.counters.wallNs;
+            s["self_ns"]     = s["self_ns"].get<uint64_t>() + selfNs[i];
+            s["cpu_ns"]      = s["cpu_ns"].get<uint64_t>() + e.counters.cpuNs;
+            s["allocs"]      = s["allocs"].get<uint64_t>() + e.counters.allocs;
+            s["alloc_bytes"] = s["alloc_bytes"].get<uint64_t>() + e.counters.allocBytes;
+        }
+        json summary = {
+            { "compiler", COMPILER_VERSION },
+            { "wall_ns", nowNs() - enabledAt },
+            { "cpu_ns", cpuNs(CLOCK_PROCESS_CPUTIME_ID) },
+            { "peak_rss_bytes", peakRssBytes() },
+            { "spans", std::move(spans) },
+        };
+
+        auto save = [&](const std::filesystem::path& file, const json& content, int indent) {
+            std::ofstream out(file, std::ios::out);
+            out << content.dump(indent, '\t') << "\n";
+            if (out) return true;
+            if (err) *err = "Could not write " + file.string();
+            return false;
+        };
+
+        std::filesystem::path summaryPath = path;
+        summaryPath.replace_extension(".summary.json");
+        return save(path, { { "traceEvents", std::move(traceEvents) }, { "displayTimeUnit", "ns" } }, -1) && save(summaryPath, summary, 1);
+    }
+}
@@ -0,0 +1,50 @@
+// core/trace.hpp
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Phase instrumentation. A Span measures a piece of work: wall and CPU time of its thread in ns and the
+// allocations (operator new) its thread made meanwhile. Spans always measure, main prints the phase times from them.
+// After enable() (-trace=<file>) every finished span is also recorded -> write() saves them as a Chrome trace
+// (chrome://tracing, ui.perfetto.dev) where spans of one thread nest by time, plus a summary per span name.
+namespace trace {
+
+    struct Counters {
+        uint64_t wallNs     = 0;
+        uint64_t cpuNs      = 0;    // CPU time of the span's thread
+        uint64_t allocs     = 0;
+        uint64_t allocBytes = 0;
+    };
+
+    class Span {
+    public:
+        // detail -> shown next to the name (file, function), only copied while recording
+        explicit Span(const char* name, std::string_view detail = {});
+        ~Span() { end(); }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+        // stops it, later calls return the same values
+        Counters end();
+
+    private:
+        const char* name_;
+        std::string detail_;
+        uint64_t startNs_;
+        Counters start_;    // thread totals when it started, the result after end()
+        bool ended_ = false;
+    };
+
+    // spans finished from now on are recorded (process wide)
+    void enable();
+    bool enabled();
+
+    // path -> Chrome trace-event JSON, path with .summary.json instead of its extension -> totals per span name,
+    // process CPU time and peak RSS
+    bool write(const std::string& path, std::string* err = nullptr);
+
+    uint64_t peakRssBytes();
+}
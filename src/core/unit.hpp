@@ -0,0 +1,18 @@
+// core/unit.hpp
+#pragma once
+
+#include "./source.hpp"
+#include "./arena.hpp"
+#include "./varPool.hpp"
+
+class ASTNode;
+
+// Everything that belongs to one compiled file.
+// Tokens point into source, AST nodes live in arena and their semantic data in vars
+// -> all of them have to outlive every phase, they are released together.
+struct CompilationUnit {
+    Source source;
+    Arena arena;
+    VarPool vars;
+    ASTNode* root = nullptr;
+};
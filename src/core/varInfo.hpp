@@ -3,6 +3,9 @@
 
 #include <string>
 
+#include "./interner.hpp"
+#include "./constant.hpp"
+
 enum class DataType {
     INT, FLOAT, BOOL, STRING, UNKNOWN
 };
@@ -13,18 +16,18 @@ enum class VarStorageType {
 
 
 struct VarInfo {
-    std::string name;
+    SymbolId name;
     
     // --- Semantic Data ---
     DataType dataType;
     //int scopeLevel;      // Scope depth when the variable was initialized
     bool isConstant;
-    std::string constValue;
+    Constant constValue;
 
     // --- Minecraft Data (Backend) ---
     VarStorageType storageType;
-    std::string storageIdent;  
-    std::string storagePath;
+    SymbolId storageIdent;     // scoreboard objective
+    SymbolId storagePath;      // score holder
     
     // --- Additional Flags ---
     bool isUsed;
@@ -0,0 +1,53 @@
+// core/varPool.hpp
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "./varInfo.hpp"
+
+using VarId = uint32_t;
+inline constexpr VarId NO_VAR = UINT32_MAX;
+
+// Semantic data of one compilation unit, nodes and scopes only keep a VarId.
+// VarInfos live in fixed size chunks -> growing the pool never moves them, so VarInfo* returned by visits stay valid.
+// Constants (literals & folded values) with the same type and name are stored once.
+class VarPool {
+public:
+    VarId add(const VarInfo& info) {
+        if (size_ % CHUNK_SIZE == 0) chunks_.push_back(std::make_unique<VarInfo[]>(CHUNK_SIZE));
+        chunks_.back()[size_ % CHUNK_SIZE] = info;
+        return size_++;
+    }
+
+    VarInfo& operator[](VarId id) { return chunks_[id / CHUNK_SIZE][id % CHUNK_SIZE]; }
+    const VarInfo& operator[](VarId id) const { return chunks_[id / CHUNK_SIZE][id % CHUNK_SIZE]; }
+
+    // NO_VAR if constant wasn't added yet
+    VarId findConstant(DataType type, SymbolId name) const {
+        auto it = constants_.find(constantKey(type, name));
+        return it != constants_.end() ? it->second : NO_VAR;
+    }
+
+    VarId addConstant(const VarInfo& info) {
+        VarId id = add(info);
+        constants_.emplace(constantKey(info.dataType, info.name), id);
+        return id;
+    }
+
+    size_t size() const { return size_; }
+    size_t constantCount() const { return constants_.size(); }
+
+private:
+    static constexpr size_t CHUNK_SIZE = 1024;
+
+    std::vector<std::unique_ptr<VarInfo[]>> chunks_;
+    uint32_t size_ = 0;
+    std::unordered_map<uint64_t, VarId> constants_;
+
+    static uint64_t constantKey(DataType type, SymbolId name) {
+        return (static_cast<uint64_t>(type) << 32) | name.id;
+    }
+};
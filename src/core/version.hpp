@@ -0,0 +1,22 @@
+// core/version.hpp
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "./hash.hpp"
+#include "./source.hpp"
+
+// bump on releases, anything cached by the compiler is keyed by it (together with the hash of the executable)
+inline constexpr std::string_view COMPILER_VERSION = "0.2.0";
+
+// version + hash of the running executable -> every rebuild of the compiler invalidates what older builds saved
+inline uint64_t compilerId() {
+    static const uint64_t id = [] {
+        uint64_t h = hashBytes(COMPILER_VERSION);
+        Source exe;
+        if (exe.loadFromFile("/proc/self/exe")) h = hashBytes(exe.text(), h);
+        return h;
+    }();
+    return id;
+}
@@ -1,30 +1,28 @@
 // core/visitor.hpp
 #pragma once
 
-#include <variant>
-#include <memory>
-
-// Forward declarations
-class CommandNode;
-class VarDeclNode;
-class ExprNode;
-class BinaryOpNode;
-class IfNode;
-class WhileNode;
-class ScopeNode;
-
-struct VarInfo;
-using ASTReturn = std::variant<std::monostate, std::shared_ptr<VarInfo>>;
+#include "./ast.hpp"
 
+// Static visitor -> dispatch is one switch on node.kind, no virtual calls and no RTTI.
+// Derived class implements visitCommand, visitVarDecl, visitExpr, visitBinaryOp, visitIf, visitWhile
+// and visitScope, all of them returning R.
+//
+//   class Impl : public ASTVisitor<Impl, VarInfo*> { ... };
+template<typename Derived, typename R = void>
 class ASTVisitor {
 public:
-    virtual ~ASTVisitor() = default;
+    R visit(const ASTNode& node) {
+        Derived& self = static_cast<Derived&>(*this);
 
-    virtual ASTReturn visitCommand  (const CommandNode& node)   = 0;
-    virtual ASTReturn visitVarDecl  (const VarDeclNode& node)   = 0;
-    virtual ASTReturn visitExpr     (const ExprNode& node)      = 0;
-    virtual ASTReturn visitBinaryOp (const BinaryOpNode& node)  = 0;
-    virtual ASTReturn visitIf       (const IfNode& node)        = 0;
-    virtual ASTReturn visitWhile    (const WhileNode& node)     = 0;
-    virtual ASTReturn visitScope    (const ScopeNode& node)     = 0;
-};
\ No newline at end of file
+        switch (node.kind) {
+            case NodeKind::COMMAND:     return self.visitCommand (static_cast<const CommandNode&> (node));
+            case NodeKind::VAR_DECL:    return self.visitVarDecl (static_cast<const VarDeclNode&> (node));
+            case NodeKind::EXPR:        return self.visitExpr    (static_cast<const ExprNode&>    (node));
+            case NodeKind::BINARY_OP:   return self.visitBinaryOp(static_cast<const BinaryOpNode&>(node));
+            case NodeKind::IF:          return self.visitIf      (static_cast<const IfNode&>      (node));
+            case NodeKind::WHILE:       return self.visitWhile   (static_cast<const WhileNode&>   (node));
+            case NodeKind::SCOPE:       return self.visitScope   (static_cast<const ScopeNode&>   (node));
+        }
+        __builtin_unreachable(); // every kind is handled above
+    }
+};
@@ -0,0 +1,43 @@
+// driver/cache.hpp
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct Options;
+
+// On-disk cache of generated functions (-cache-dir=<dir>). One entry is a directory <dir>/<key as hex>/ holding the
+// .mcfunction files of one compiled script. The key covers everything the output depends on:
+// the source bytes, the options that change the output, the compiler build and the commands.json it validates against.
+// A hit hard-links the files into the output directory without lexing the script at all. The generator replaces
+// output files instead of rewriting them, so recompiling never writes through such a link.
+// Safe to use from many threads (project mode), entries are published with a rename so readers never see half of one.
+class CompileCache {
+public:
+    explicit CompileCache(fs::path dir);
+
+    // options must already hold the dpPath the file is generated with (function calls are written with it)
+    uint64_t key(std::string_view source, const Options& options, uint64_t commandsHash) const;
+
+    // copies the cached functions into out, false on a miss
+    bool restore(uint64_t key, const fs::path& out);
+
+    // saves the files generated for key, failures only cost a miss next time
+    void store(uint64_t key, const std::vector<fs::path>& files);
+
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+
+private:
+    fs::path dir_;
+    std::atomic<size_t> hits_ = 0;
+    std::atomic<size_t> misses_ = 0;
+    std::atomic<size_t> tmpCounter_ = 0;
+
+    fs::path entryPath(uint64_t key) const;
+};
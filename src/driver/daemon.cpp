@@ -0,0 +1,337 @@
+// driver/daemon.cpp
+#include "./daemon.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "./project.hpp"
+#include "./../core/hash.hpp"
+#include "./../core/options.hpp"
+#include "./../core/source.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+class Daemon::Impl {
+public:
+    Impl(const Options& options, SimplifiedCommandRegistry& reg, CompileCache* cache)
+        : options_(options), reg_(reg), cache_(cache) {
+        inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_ < 0) perror("inotify");
+    }
+
+    ~Impl() {
+        if (inotify_ >= 0) close(inotify_);
+    }
+
+    bool watch(const fs::path& input) {
+        auto start = Clock::now();
+        fs::path path = normalize(input);
+
+        std::error_code ec;
+        if (fs::is_directory(path, ec)) {
+            // same output as project mode, -out only applies to the first watched project
+            fs::path out = (targets_.empty() && !options_.outPath.empty()) ? fs::path(options_.outPath) : fs::path(path.string() + "-out");
+            targets_.push_back({ path, normalize(out), true });
+            watchTree(path);
+            rescan(targets_.size() - 1);
+
+            // first build -> all files at once on the project's threads
+            const Target& target = targets_.back();
+            Project project(target.root, target.out);
+            bool ok = project.compile(options_, reg_, options_.threads, cache_) == 0;
+            for (const auto& [key, file] : files_) {
+                if (file.target == targets_.size() - 1 && ok) hashes_[key] = contentHash(file.file.input);
+            }
+            report(ok, path, start);
+            return true;
+        }
+
+        if (!fs::is_regular_file(path, ec)) {
+            std::cerr << "daemon: nothing to watch at " << input.string() << "\n";
+            return false;
+        }
+
+        // single script, its directory is watched -> editors that save by renaming a new file over it are seen too
+        targets_.push_back({ path, {}, false });
+        watchDirectory(path.parent_path());
+        ProjectFile file = scriptFile(path);
+        files_[path.string()] = { file, targets_.size() - 1 };
+        compile(file, start, true);
+        return true;
+    }
+
+    int run() {
+        std::string pending;
+        char buffer[4096];
+
+        while (true) {
+            pollfd fds[2] = { { STDIN_FILENO, POLLIN, 0 }, { inotify_, POLLIN, 0 } };
+            if (poll(fds, inotify_ >= 0 ? 2 : 1, -1) < 0) {
+                if (errno == EINTR) continue;
+                perror("poll");
+                return EXIT_FAILURE;
+            }
+            auto start = Clock::now();
+
+            if (inotify_ >= 0 && (fds[1].revents & POLLIN)) onChanges(start);
+
+            if (fds[0].revents & (POLLIN | POLLHUP)) {
+                ssize_t n = read(STDIN_FILENO, buffer, sizeof(buffer));
+                if (n <= 0) return EXIT_SUCCESS; // stdin closed
+
+                pending.append(buffer, n);
+                size_t eol;
+                while ((eol = pending.find('\n')) != std::string::npos) {
+                    std::string line = pending.substr(0, eol);
+                    pending.erase(0, eol + 1);
+                    if (!request(line, start)) return EXIT_SUCCESS;
+                }
+            }
+        }
+    }
+
+private:
+    struct Target {
+        fs::path root;      // project directory or the script itself
+        fs::path out;       // project output, empty for a script
+        bool isProject;
+    };
+
+    struct Watched {
+        ProjectFile file;
+        size_t target;
+    };
+
+    const Options& options_;
+    SimplifiedCommandRegistry& reg_;
+    CompileCache* cache_;
+
+    int inotify_ = -1;
+    std::unordered_map<int, fs::path> watches_;         // inotify watch -> directory
+    std::vector<Target> targets_;
+    std::unordered_map<std::string, Watched> files_;    // absolute input path -> how it's compiled
+    std::unordered_map<std::string, uint64_t> hashes_;  // source hash of the last successful compile
+
+    size_t compiled_ = 0, unchanged_ = 0, failed_ = 0;
+    double totalMs_ = 0, maxMs_ = 0;
+
+
+    static fs::path normalize(const fs::path& path) {
+        fs::path result = fs::absolute(path).lexically_normal();
+        if (!result.has_filename()) result = result.parent_path(); // trailing '/'
+        return result;
+    }
+
+    // compiled like the single file mode -> functions next to the script, dpPath as given
+    static ProjectFile scriptFile(const fs::path& path) {
+        std::error_code ec;
+        fs::path out = path;
+        out.replace_extension();
+        return { path, "", out, fs::file_size(path, ec) };
+    }
+
+    static uint64_t contentHash(const fs::path& path) {
+        Source source;
+        return source.loadFromFile(path.string()) ? hashBytes(source.text()) : 0;
+    }
+
+    void compile(const ProjectFile& file, Clock::time_point start, bool reportUnchanged) {
+        std::string key = file.input.string();
+        uint64_t hash = contentHash(file.input);
+
+        // editors often save without changing anything (or touch the file twice per save)
+        auto it = hashes_.find(key);
+        if (it != hashes_.end() && it->second == hash) {
+            unchanged_++;
+            if (reportUnchanged) printf("unchanged %s\n", key.c_str());
+            fflush(stdout);
+            return;
+        }
+
+        // compile errors are caught inside (core/diagnostic.hpp), the daemon keeps running
+        bool ok = compileProjectFile(file, options_, reg_, cache_);
+        if (ok) hashes_[key] = hash;
+        else hashes_.erase(key); // saving it again retries even without a change
+
+        report(ok, file.input, start);
+    }
+
+    void report(bool ok, const fs::path& path, Clock::time_point start) {
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (ok) compiled_++;
+        else failed_++;
+        totalMs_ += ms;
+        if (ms > maxMs_) maxMs_ = ms;
+
+        printf("%s %s %.2fms\n", ok ? "ok" : "error", path.string().c_str(), ms);
+        fflush(stdout);
+    }
+
+    // false -> quit
+    bool request(const std::string& line, Clock::time_point start) {
+        size_t space = line.find(' ');
+        std::string cmd = line.substr(0, space);
+        std::string arg = space == std::string::npos ? "" : line.substr(space + 1);
+
+        if (cmd.empty()) return true;
+        if (cmd == "quit") return false;
+
+        if (cmd == "compile" && !arg.empty()) {
+            fs::path path = normalize(arg);
+            auto it = files_.find(path.string());
+            compile(it != files_.end() ? it->second.file : scriptFile(path), start, true);
+        } else if (cmd == "watch" && !arg.empty()) {
+            printf("watching %s\n", normalize(arg).string().c_str());
+            fflush(stdout);
+            if (!watch(arg)) report(false, normalize(arg), start);
+        } else if (cmd == "stats") {
+            size_t runs = compiled_ + failed_;
+            printf("stats compiled=%zu unchanged=%zu failed=%zu avg=%.2fms max=%.2fms\n", compiled_, unchanged_, failed_, runs ? totalMs_ / runs : 0.0, maxMs_);
+            fflush(stdout);
+        } else {
+            printf("unknown %s\n", line.c_str());
+            fflush(stdout);
+        }
+        return true;
+    }
+
+
+    // ===== WATCHING =====
+
+    void watchDirectory(const fs::path& dir) {
+        if (inotify_ < 0) return;
+        int wd = inotify_add_watch(inotify_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_ONLYDIR);
+        if (wd >= 0) watches_[wd] = dir;
+    }
+
+    // inotify isn't recursive -> every directory of a project gets its own watch
+    void watchTree(const fs::path& root) {
+        watchDirectory(root);
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(root, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_directory()) watchDirectory(it->path());
+        }
+    }
+
+    // project that gained or lost a file -> function paths are assigned again (collisions may move)
+    // returns files that are new or compile to another place now
+    std::vector<std::string> rescan(size_t targetIdx) {
+        const Target& target = targets_[targetIdx];
+
+        std::unordered_map<std::string, std::string> before;
+        for (auto it = files_.begin(); it != files_.end();) {
+            if (it->second.target == targetIdx) {
+                before[it->first] = it->second.file.functionPath;
+                it = files_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        std::vector<std::string> moved;
+        Project project(target.root, target.out);
+        for (const ProjectFile& file : project.files()) {
+            std::string key = normalize(file.input).string();
+            files_[key] = { file, targetIdx };
+
+            auto old = before.find(key);
+            if (old == before.end() || old->second != file.functionPath) {
+                hashes_.erase(key);
+                moved.push_back(key);
+            }
+        }
+        for (const auto& [key, path] : before) {
+            if (!files_.count(key)) hashes_.erase(key);
+        }
+        return moved;
+    }
+
+    // project containing path, -1 if none
+    long projectOf(const fs::path& path) const {
+        for (size_t i = 0; i < targets_.size(); i++) {
+            if (!targets_[i].isProject) continue;
+
+            const std::string root = targets_[i].root.string() + "/";
+            if (path.string().rfind(root, 0) == 0) return i;
+        }
+        return -1;
+    }
+
+    void onChanges(Clock::time_point start) {
+        // one save is usually a few events -> everything read now is compiled once, in the order it came
+        std::vector<std::string> changed;
+        std::unordered_set<std::string> seen;
+        std::unordered_set<size_t> rescans;
+        auto add = [&](const std::string& key) {
+            if (seen.insert(key).second) changed.push_back(key);
+        };
+
+        alignas(inotify_event) char buffer[16384];
+        ssize_t n;
+        while ((n = read(inotify_, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + n;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                p += sizeof(inotify_event) + event->len;
+
+                auto dir = watches_.find(event->wd);
+                if (dir == watches_.end() || event->len == 0) continue;
+                fs::path path = dir->second / event->name;
+                long project = projectOf(path);
+
+                if (event->mask & IN_ISDIR) {
+                    if (project >= 0 && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                        watchTree(path);
+                        rescans.insert(project);
+                    } else if (project >= 0) {
+                        rescans.insert(project);
+                    }
+                    continue;
+                }
+                if (path.extension() != ".mcjava") continue;
+
+                // a new file is picked up once it's written (IN_CREATE comes while it's still empty)
+                if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                    if (files_.count(path.string())) add(path.string());
+                    else if (project >= 0) rescans.insert(project);
+                } else if (project >= 0 && (event->mask & (IN_DELETE | IN_MOVED_FROM))) {
+                    rescans.insert(project);
+                }
+            }
+        }
+
+        for (size_t project : rescans) {
+            for (const std::string& key : rescan(project)) add(key);
+        }
+
+        for (const std::string& key : changed) {
+            auto it = files_.find(key);
+            std::error_code ec;
+            if (it != files_.end() && fs::exists(it->second.file.input, ec)) compile(it->second.file, start, false);
+        }
+    }
+};
+
+
+// ========== WRAPPER ==========
+Daemon::Daemon(const Options& options, SimplifiedCommandRegistry& reg, CompileCache* cache)
+    : pImpl(std::make_unique<Impl>(options, reg, cache)) {}
+
+Daemon::~Daemon() = default; // Needed for unique_ptr<Impl>
+
+bool Daemon::watch(const fs::path& input) {
+    return pImpl->watch(input);
+}
+
+int Daemon::run() {
+    return pImpl->run();
+}
@@ -0,0 +1,39 @@
+// driver/daemon.hpp
+#pragma once
+
+#include <filesystem>
+#include <memory>
+
+namespace fs = std::filesystem;
+
+struct Options;
+class SimplifiedCommandRegistry;
+class CompileCache;
+
+// Daemon mode (-daemon): the process stays up with the command registry loaded and recompiles scripts as they change.
+// Watched inputs (a script or a project directory) are followed with inotify, every saved file whose content changed is
+// compiled again right away. Requests come line by line on stdin, every result is one line on stdout:
+//
+//   compile <file>   ->  ok <file> <ms>ms | error <file> <ms>ms | unchanged <file>
+//   watch <path>     ->  watching <path>, then ok/error <path> <ms>ms of its first build
+//   stats            ->  stats compiled=<n> unchanged=<n> failed=<n> avg=<ms>ms max=<ms>ms
+//   quit
+//
+// Paths are printed absolute. Results of file changes are printed the same way as compile requests, the time is
+// measured from the moment the change was read. Compile errors are printed to stderr, the daemon keeps running.
+class Daemon {
+public:
+    Daemon(const Options& options, SimplifiedCommandRegistry& reg, CompileCache* cache = nullptr);
+    ~Daemon();
+
+    // starts following a script or a project directory (output like the single file / project mode), builds it once
+    bool watch(const fs::path& input);
+
+    // serves stdin & file changes until 'quit' or the end of stdin
+    int run();
+
+private:
+    // implementation
+    class Impl;
+    std::unique_ptr<Impl> pImpl;
+};
@@ -0,0 +1,156 @@
+// driver/project.cpp
+#include "./project.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <unordered_set>
+
+#include "./../frontend/tokenizer.hpp"
+#include "./../frontend/parser.hpp"
+#include "./../middleend/resolver.hpp"
+#include "./../middleend/analyzer.hpp"
+#include "./../backend/generator.hpp"
+
+#include "./../registries/SimplifiedCommandRegistry.hpp"
+#include "./../core/options.hpp"
+#include "./../core/threadPool.hpp"
+#include "./../core/unit.hpp"
+#include "./../core/ast.hpp"
+#include "./../core/diagnostic.hpp"
+#include "./../core/trace.hpp"
+#include "./cache.hpp"
+
+namespace {
+
+    // function paths may only use [a-z0-9_.-/] -> everything else becomes '_'
+    std::string toFunctionPath(const fs::path& relative) {
+        std::string path = relative.generic_string();
+        path = path.substr(0, path.size() - relative.extension().string().size());
+
+        for (char& c : path) {
+            if (c >= 'A' && c <= 'Z') c = c - 'A' + 'a';
+            else if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '-' || c == '.' || c == '/')) c = '_';
+        }
+        return path;
+    }
+}
+
+bool compileProjectFile(const ProjectFile& file, const Options& base, SimplifiedCommandRegistry& reg, CompileCache* cache, OptimizationStats* stats) try {
+    Options options = base;
+    if (!file.functionPath.empty()) options.dpPath = base.dpPath + file.functionPath + "/";
+    options.silent = true; // per file messages from many threads would only interleave
+    trace::Span span("file", file.input.string()); // phases below nest in it on the worker's thread
+
+    CompilationUnit unit;
+    std::string err;
+    if (!unit.source.loadFromFile(file.input.string(), &err)) {
+        std::cerr << "input error: " << file.input.string() << ": " << err << "\n";
+        return false;
+    }
+
+    uint64_t key = 0;
+    if (options.stats) cache = nullptr; // a restored file has nothing to count
+    if (cache && !options.onlyAnalysis) {
+        trace::Span restoring("cache restore");
+        key = cache->key(unit.source.text(), options, reg.sourceHash());
+        if (cache->restore(key, file.output)) return true;
+    }
+
+    trace::Span parsing("parse", "streamed tokens");
+    Tokenizer tokenizer(unit.source, reg);
+    Parser parser(tokenizer, unit.source, reg, unit.arena);
+    unit.root = parser.parse();
+    parsing.end();
+    if (!unit.root) {
+        std::cerr << "Parse failed: no AST generated for " << file.input.string() << std::endl;
+        return false;
+    }
+
+    trace::Span resolving("resolve");
+    Resolver resolver;
+    resolver.resolve(*unit.root);
+    resolving.end();
+
+    trace::Span analyzing("analyze");
+    Analyzer analyzer(options, unit.source, unit.vars);
+    analyzer.analyze(*unit.root);
+    analyzing.end();
+    if (stats) stats->add(analyzer.getStats());
+    if (options.onlyAnalysis) return true;
+
+    std::error_code ec;
+    fs::create_directories(file.output, ec);
+    if (ec) {
+        std::cerr << "FILE ERROR: " << file.output.string() << ": " << ec.message() << '\n';
+        return false;
+    }
+
+    trace::Span generating("generate");
+    fs::path path = file.output;
+    FunctionGenerator funcGen(path, options, analyzer.getScopes(), unit.source, unit.vars);
+    funcGen.generate(*unit.root);
+    generating.end();
+    if (stats) stats->add(funcGen.stats());
+
+    if (cache) {
+        trace::Span storing("cache store");
+        cache->store(key, funcGen.files());
+    }
+    return true;
+} catch (const CompileError& e) {
+    // only this file fails, the other threads keep compiling
+    std::cerr << file.input.string() << ": " << e.what() << std::endl;
+    return false;
+}
+
+Project::Project(const fs::path& root, const fs::path& out) {
+    std::vector<fs::path> inputs;
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(root, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (it->is_regular_file() && it->path().extension() == ".mcjava") inputs.push_back(it->path());
+    }
+    std::sort(inputs.begin(), inputs.end());
+
+    // two files can end up with the same function path (A.mcjava & a.mcjava) -> later ones get _2, _3, ...
+    std::unordered_set<std::string> used;
+    for (const fs::path& input : inputs) {
+        std::string base = toFunctionPath(fs::relative(input, root));
+        std::string name = base;
+        for (int i = 2; !used.insert(name).second; i++) name = base + "_" + std::to_string(i);
+
+        files_.push_back({ input, name, out / name, fs::file_size(input, ec) });
+    }
+}
+
+size_t Project::compile(const Options& options, SimplifiedCommandRegistry& reg, size_t threads, CompileCache* cache) {
+    std::string err;
+    if (!reg.wait(&err)) {
+        std::cerr << "cmd load error: " << err << "\n";
+        return files_.size();
+    }
+
+    // biggest files are queued last -> every worker starts with its biggest file (workers pop their own deque from the back)
+    std::vector<const ProjectFile*> order;
+    for (const auto& file : files_) order.push_back(&file);
+    std::stable_sort(order.begin(), order.end(), [](const ProjectFile* a, const ProjectFile* b) { return a->size < b->size; });
+
+    // one per file -> workers never share one, added up in path order afterwards
+    std::vector<OptimizationStats> stats(options.stats ? files_.size() : 0);
+
+    std::atomic<size_t> failed = 0;
+    {
+        ThreadPool pool(threads);
+        for (const ProjectFile* file : order) {
+            OptimizationStats* fileStats = options.stats ? &stats[file - files_.data()] : nullptr;
+            pool.submit([&, file, fileStats] {
+                if (!compileProjectFile(*file, options, reg, cache, fileStats)) failed++;
+            });
+        }
+        pool.wait();
+    }
+
+    stats_ = {};
+    for (const OptimizationStats& s : stats) stats_.add(s);
+    return failed;
+}
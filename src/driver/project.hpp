@@ -0,0 +1,50 @@
+// driver/project.hpp
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "./../core/stats.hpp"
+
+namespace fs = std::filesystem;
+
+struct Options;
+class SimplifiedCommandRegistry;
+class CompileCache;
+
+// One script of a project
+struct ProjectFile {
+    fs::path input;
+    std::string functionPath;   // relative path without extension, made a valid function path and unique
+    fs::path output;            // out / functionPath
+    uintmax_t size = 0;         // bytes, biggest files are started first
+};
+
+// Project mode: every .mcjava file under a source root is compiled on its own thread (see core/threadPool.hpp)
+// into one datapack namespace. A file's functions go to <out>/<functionPath>/ and are called as
+// <dpPrefix>:<dpPath><functionPath>/<name>, so two scripts never fight over a function name.
+class Project {
+public:
+    // collects the files, sorted by path -> function paths are the same every run
+    Project(const fs::path& root, const fs::path& out);
+
+    const std::vector<ProjectFile>& files() const { return files_; }
+
+    // compiles all files with the given number of threads (0 = hardware threads), returns number of files that failed
+    // the registry is shared by all of them, it is waited for before the first file starts
+    // files found in the cache (if there is one) are copied from it instead
+    size_t compile(const Options& options, SimplifiedCommandRegistry& reg, size_t threads, CompileCache* cache = nullptr);
+
+    // -stats of the last compile, files added in path order
+    const OptimizationStats& stats() const { return stats_; }
+
+private:
+    std::vector<ProjectFile> files_;
+    OptimizationStats stats_;
+};
+
+// whole pipeline for one file, the same phases as the single file mode in main.cpp (without dumps)
+// a file with an empty functionPath keeps options.dpPath as it is -> compiled like a single script
+// stats -> filled with what the analyzer & generator counted (options.stats skips the cache)
+bool compileProjectFile(const ProjectFile& file, const Options& options, SimplifiedCommandRegistry& reg, CompileCache* cache = nullptr, OptimizationStats* stats = nullptr);
@@ -0,0 +1,151 @@
+// frontend/lexer_tables.hpp
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "./../core/token.hpp"
+
+// Compile-time tables used by the tokenizer, every classification is a table load
+namespace lex {
+
+// ===== CHARACTER CLASSES =====
+
+enum CharClass : uint8_t {
+    CC_ALPHA        = 1 << 0,   // [A-Za-z]       -> start of identifier / keyword / command
+    CC_DIGIT        = 1 << 1,   // [0-9]
+    CC_IDENT        = 1 << 2,   // [A-Za-z0-9_-]  -> rest of identifier
+    CC_ANNOTATION   = 1 << 3,   // [A-Za-z0-9_]   -> annotation name
+    CC_SPACE        = 1 << 4,   // same set as std::isspace in "C" locale
+    CC_SINGLE       = 1 << 5,   // char is a token on its own (see CharInfo::single)
+    CC_DOUBLE_START = 1 << 6,   // char can start a two char operator
+};
+
+struct CharInfo {
+    uint8_t   cls    = 0;
+    TokenType single = TokenType::END_OF_FILE; // valid only with CC_SINGLE
+};
+
+constexpr std::array<CharInfo, 256> makeCharTable() {
+    std::array<CharInfo, 256> t{};
+
+    for (int c = 'a'; c <= 'z'; c++) t[c].cls |= CC_ALPHA | CC_IDENT | CC_ANNOTATION;
+    for (int c = 'A'; c <= 'Z'; c++) t[c].cls |= CC_ALPHA | CC_IDENT | CC_ANNOTATION;
+    for (int c = '0'; c <= '9'; c++) t[c].cls |= CC_DIGIT | CC_IDENT | CC_ANNOTATION;
+    t['_'].cls |= CC_IDENT | CC_ANNOTATION;
+    t['-'].cls |= CC_IDENT;
+
+    for (unsigned char c : { ' ', '\t', '\n', '\v', '\f', '\r' }) t[c].cls |= CC_SPACE;
+
+    constexpr std::pair<char, TokenType> singles[] = {
+        {'+', TokenType::PLUS},
+        {'-', TokenType::MINUS},
+        {'*', TokenType::MULTIPLY},
+        {'/', TokenType::DIVIDE},
+
+        {'=', TokenType::EQUALS},
+        {'<', TokenType::LESS},
+        {'>', TokenType::GREATER},
+
+        {'(', TokenType::OPEN_PAREN},
+        {')', TokenType::CLOSE_PAREN},
+        {'{', TokenType::OPEN_BRACE},
+        {'}', TokenType::CLOSE_BRACE},
+        {'[', TokenType::OPEN_BRACKET},
+        {']', TokenType::CLOSE_BRACKET},
+
+        {';', TokenType::SEMI_COLON},
+        {',', TokenType::COMMA},
+        {'.', TokenType::DOT},
+    };
+    for (auto [c, type] : singles) {
+        t[(unsigned char)c].cls   |= CC_SINGLE;
+        t[(unsigned char)c].single = type;
+    }
+
+    for (unsigned char c : { '=', '!', '<', '>' }) t[c].cls |= CC_DOUBLE_START;
+
+    return t;
+}
+
+inline constexpr std::array<CharInfo, 256> CHAR_TABLE = makeCharTable();
+
+inline constexpr bool is(char c, uint8_t cls) {
+    return CHAR_TABLE[(unsigned char)c].cls & cls;
+}
+
+
+
+// ===== PERFECT HASH =====
+// Hash only looks at length, first and last char. The seed is searched at compile time until
+// every key lands in its own slot, so a lookup is one hash, one table load and one compare.
+
+struct HashEntry {
+    std::string_view key;
+    TokenType type;
+};
+
+template<size_t TableSize>
+struct PerfectHashTable {
+    static_assert((TableSize & (TableSize - 1)) == 0, "TableSize must be power of 2");
+
+    std::array<HashEntry, TableSize> slots{};
+    uint32_t seed = 0;
+
+    static constexpr uint32_t hash(std::string_view s, uint32_t seed) {
+        uint32_t h = static_cast<uint32_t>(s.size());
+        h = h * seed + static_cast<unsigned char>(s.front());
+        h = h * seed + static_cast<unsigned char>(s.back());
+        return (h ^ (h >> 7)) & (TableSize - 1);
+    }
+
+    // returns fallback when s is not a key
+    constexpr TokenType find(std::string_view s, TokenType fallback) const {
+        if (s.empty()) return fallback;
+        const HashEntry& e = slots[hash(s, seed)];
+        return e.key == s ? e.type : fallback;
+    }
+};
+
+template<size_t TableSize, size_t N>
+constexpr PerfectHashTable<TableSize> makePerfectHash(const std::array<HashEntry, N>& entries) {
+    for (uint32_t seed = 1; seed < 100000; seed++) {
+        PerfectHashTable<TableSize> table{};
+        table.seed = seed;
+
+        bool ok = true;
+        for (const auto& e : entries) {
+            auto& slot = table.slots[PerfectHashTable<TableSize>::hash(e.key, seed)];
+            if (!slot.key.empty()) { ok = false; break; }
+            slot = e;
+        }
+        if (ok) return table;
+    }
+    return {}; // seed == 0 -> caught by static_assert below
+}
+
+
+inline constexpr auto KEYWORDS = makePerfectHash<16>(std::array<HashEntry, 7>{{
+    {"while",  TokenType::WHILE},
+    {"for",    TokenType::FOR},
+    {"if",     TokenType::IF},
+    {"else",   TokenType::ELSE},
+    {"return", TokenType::RETURN},
+    {"true",   TokenType::TRUE},
+    {"false",  TokenType::FALSE},
+}});
+static_assert(KEYWORDS.seed != 0, "No perfect hash found for keywords");
+
+inline constexpr auto DOUBLE_CHARS = makePerfectHash<8>(std::array<HashEntry, 4>{{
+    {"==", TokenType::EQUALS_EQUALS},
+    {"!=", TokenType::NOT_EQUALS},
+    {"<=", TokenType::LESS_EQUAL},
+    {">=", TokenType::GREATER_EQUAL},
+}});
+static_assert(DOUBLE_CHARS.seed != 0, "No perfect hash found for double char operators");
+
+// IDENT is never a keyword -> used as "not found"
+inline constexpr TokenType NOT_FOUND = TokenType::IDENT;
+
+} // namespace lex
@@ -1,18 +1,41 @@
 // frontend/parser.cpp
 #include "./parser.hpp"
 
+#include <array>
+#include <iostream>
+#include <sstream>
+#include <optional>
+
+#include "./tokenizer.hpp"
+
 #include "./registries/SimplifiedCommandRegistry.hpp"
 #include "./core/token.hpp"
+#include "./core/source.hpp"
 #include "./core/ast.hpp"
+#include "./core/arena.hpp"
+#include "./core/interner.hpp"
+#include "./core/diagnostic.hpp"
 
 class Parser::Impl {
 public:
-    Impl(std::vector<Token> tokens, SimplifiedCommandRegistry& reg)
-    : tokens_(std::move(tokens)), reg_(reg), pos_(0) {}
+    Impl(std::vector<Token> tokens, Source& source, SimplifiedCommandRegistry& reg, Arena& arena)
+    : tokens_(std::move(tokens)), source_(source), reg_(reg), arena_(arena), pos_(0) {}
 
-    std::unique_ptr<ASTNode> parse() {
-        auto scope = std::make_unique<ScopeNode>();
+    Impl(Tokenizer& tokenizer, Source& source, SimplifiedCommandRegistry& reg, Arena& arena)
+    : tokenizer_(&tokenizer), source_(source), reg_(reg), arena_(arena), pos_(0) {}
+
+    ASTNode* parse() {
+        size_t base = nodeStack_.size();
+        
+        // every statement goes to the global scope
+        while (auto stmt = parseNext(nullptr)) {
+            nodeStack_.push_back(stmt);
+        }
+        return arena_.make<ScopeNode>(takeNodes(base));
         
+    }
+
+    ASTNode* parseNext(StatementStart* start) {
         while (hasTokens()) {
             // Skip newlines and random semi colons
             if (peek().type == TokenType::NEW_LINE || peek().type == TokenType::SEMI_COLON){
@@ -23,27 +46,54 @@ public:
             // End if thats the end
             if (peek().type == TokenType::END_OF_FILE) break;
             
-            // Parse statement and add it to the global scope
-            if (auto stmt = parseStatement()) {
-                scope->statements.push_back(std::move(stmt));
-            } else {
-                error(true, peek().line, peek().col, "Failed to parse statement: ", tokenTypeToString(peek().type));
+            if (start) {
+                Token prev = peek(-1); // END_OF_FILE before the first token
+                start->text      = pos_ == 0 ? 0 : prev.offset + prev.length;
+                start->token     = peek().offset;
+                start->separated = pos_ == 0 || canSkip(prev.type);
             }
+            if (auto stmt = parseStatement()) return stmt;
+
+            error(true, peek(), "Failed to parse statement: ", tokenTypeToString(peek().type));
         }
-        return scope;
-        
+        return nullptr;
     }
 
 private: 
+    // tokens come either from already tokenized vector or straight from the tokenizer (streaming)
     std::vector<Token> tokens_;
+    Tokenizer* tokenizer_ = nullptr;
+
+    Source& source_;
     SimplifiedCommandRegistry& reg_;
-    size_t pos_;
+    Arena& arena_;  // every node is allocated here
+    size_t pos_;    // absolute index of the next token
+
+    // window of pulled tokens, token i lives in window_[i % WINDOW]
+    // parser needs peek(0), peek(1) and peek(-1) -> 3 slots, 4 to keep the modulo cheap
+    static constexpr size_t WINDOW = 4;
+    std::array<Token, WINDOW> window_;
+    size_t pulled_ = 0;             // number of tokens pulled so far
+    size_t eofPos_ = SIZE_MAX;      // absolute index of END_OF_FILE once it was pulled
+
+    const Token eofToken_ = { .type = TokenType::END_OF_FILE };
+    std::optional<Token> zeroToken_; // "0" for the unary minus expansion, doesn't exist in source
     
     std::vector<Annotation> pendingAnnotations;
 
+    // children of all scopes / commands that are being parsed, each list is moved into the arena as one contiguous block when finished
+    std::vector<ASTNode*> nodeStack_;
+
 
     // ===== HELPER METHODS =====   
 
+    // moves nodes pushed since base into the arena
+    NodeList takeNodes(size_t base) {
+        NodeList nodes = arena_.copy(nodeStack_.data() + base, nodeStack_.size() - base);
+        nodeStack_.resize(base);
+        return nodes;
+    }
+
     void skipNewLines() {
         while(hasTokens() && canSkip(peek().type)) consume();
     }
@@ -66,7 +116,7 @@ private:
 
     // ===== PARSE LOGIC =====
 
-    std::unique_ptr<ASTNode> parseStatement() {
+    ASTNode* parseStatement() {
         skipNewLines();
         if (!hasTokens()) return nullptr;
 
@@ -80,7 +130,7 @@ private:
         if (!hasTokens()) return nullptr;
 
         Token tok = peek();
-        std::unique_ptr<ASTNode> node;
+        ASTNode* node = nullptr;
 
         // 1. Variable assignment (x = 5)
         if (tok.type == TokenType::IDENT && peek(1).type == TokenType::EQUALS) {
@@ -111,40 +161,61 @@ private:
         // append annotations
         if (node) {
             if (!pendingAnnotations.empty()) {
-                node->annotations = pendingAnnotations;
+                node->annotations = arena_.copy(pendingAnnotations.data(), pendingAnnotations.size());
                 pendingAnnotations.clear();
             }
 
             return node;
         }
 
-        error(true, tok.line, tok.col, "Unknown statement type: ", tokenTypeToString(tok.type));
+        error(true, tok, "Unknown statement type: ", tokenTypeToString(tok.type));
         return nullptr;
     }
 
     void parseAnnotation() {
         Token name = consume(); // consume ANNOTATION
-        if (!name.value.has_value()) error("Encountered annotation without a name");
+        if (name.length == 0) error("Encountered annotation without a name");
 
         // push_back annotation struct
-        pendingAnnotations.push_back({name.value.value()});
+        pendingAnnotations.push_back({source_.lexeme(name)});
     }
 
 
-    std::unique_ptr<ASTNode> parseVarDecl() {
+    ASTNode* parseVarDecl() {
         Token name = consume(); // consume IDENT
         consume(); // consume '='
 
-        if (!name.value.has_value()) error("Encountered variable assignation without name");
+        if (name.length == 0) error("Encountered variable assignation without name");
         auto value = parseExpression();
 
-        return std::make_unique<VarDeclNode>(name, std::move(value));
+        return arena_.make<VarDeclNode>(name, intern(source_.lexeme(name)), value);
     }
 
 
-    std::unique_ptr<ASTNode> parseCommand() {
+    ASTNode* parseCommand() {
         Token cmdKey = consume(); // consume CMD_KEY
-        auto node = std::make_unique<CommandNode>(cmdKey);
+
+        // raw command -> checked against the command tree from mcdoc and emitted as written
+        if (source_.lexeme(cmdKey) != "say") {
+            Token text = {};
+            if (hasTokens() && peek().type == TokenType::COMMAND_TEXT) text = consume();
+
+            std::string_view args = text.length > 0 ? source_.lexeme(text) : std::string_view();
+            CommandMatch match = reg_.trie().match(source_.lexeme(cmdKey), args);
+            if (!match.ok) {
+                if (match.errorOffset >= args.size()) {
+                    error(true, cmdKey, "Incomplete command: '", source_.lexeme(cmdKey), args.empty() ? "" : " ", args, "'");
+                }
+                Token at = { .type = TokenType::COMMAND_TEXT, .offset = text.offset + static_cast<uint32_t>(match.errorOffset), .length = 0 };
+                error(true, at, "Invalid command argument '", args.substr(match.errorOffset, args.find(' ', match.errorOffset) - match.errorOffset), "' in '", source_.lexeme(cmdKey), " ", args, "'");
+            }
+
+            auto node = arena_.make<CommandNode>(cmdKey, NodeList{}, text);
+            skipNewLines();
+            return node;
+        }
+
+        size_t base = nodeStack_.size();
 
         // Collect all arguments to the end of the line or semi colon
         while (hasTokens() && 
@@ -152,15 +223,16 @@ private:
                peek().type != TokenType::END_OF_FILE &&
                peek().type != TokenType::SEMI_COLON) {
             
-            node->args.push_back(parseExpression());
+            nodeStack_.push_back(parseExpression());
         }
 
+        auto node = arena_.make<CommandNode>(cmdKey, takeNodes(base));
         skipNewLines();
         return node;
     }
 
 
-    std::unique_ptr<ASTNode> parseIf() {
+    ASTNode* parseIf() {
         consume(); // consume 'if'
         expect(TokenType::OPEN_PAREN, "after 'if'");
         consume(); // consume '('
@@ -172,12 +244,12 @@ private:
 
         auto thenBranch = parseStatement();
 
-        std::unique_ptr<ASTNode> elseBranch = nullptr;
+        ASTNode* elseBranch = nullptr;
         if (hasTokens() && peek().type == TokenType::ELSE) {
             consume(); // consume 'else'
 
             if (!hasTokens()) {
-                error(true, peek().line, peek().col, "Expected 'if' or scope after 'else'");
+                error(true, peek(), "Expected 'if' or scope after 'else'");
             }
 
             if (peek().type == TokenType::OPEN_BRACE) {
@@ -185,19 +257,15 @@ private:
             } else if (peek().type == TokenType::IF) {
                 elseBranch = parseIf();
             } else {
-                error(true, peek().line, peek().col, "Expected 'if' or scope after 'else', but got ", tokenTypeToString(peek().type));
+                error(true, peek(), "Expected 'if' or scope after 'else', but got ", tokenTypeToString(peek().type));
             }
         }
 
-        return std::make_unique<IfNode>(
-            std::move(condition), 
-            std::move(thenBranch), 
-            std::move(elseBranch)
-        );
+        return arena_.make<IfNode>(condition, thenBranch, elseBranch);
     }
 
 
-    std::unique_ptr<ASTNode> parseWhile() {
+    ASTNode* parseWhile() {
         consume(); // consume 'while'
         expect(TokenType::OPEN_PAREN, "after 'while'");
         consume(); // consume '('
@@ -209,28 +277,25 @@ private:
 
         auto body = parseStatement();
 
-        return std::make_unique<WhileNode>(
-            std::move(condition), 
-            std::move(body)
-        );
+        return arena_.make<WhileNode>(condition, body);
     }
 
-    std::unique_ptr<ASTNode> parseScope() {
+    ASTNode* parseScope() {
         consume(); // consume '{'
-        auto scope = std::make_unique<ScopeNode>();
+        size_t base = nodeStack_.size();
 
         while (hasTokens() && peek().type != TokenType::CLOSE_BRACE) {
             if (auto stmt = parseStatement()) {
-                scope->statements.push_back(std::move(stmt));
+                nodeStack_.push_back(stmt);
             }
 
            skipNewLines(); // needed -> without this there could be Tokens (NEW_LINE, CLOSE_BRACE) and because parseStatement skips newlines it would fail on '}'
         }
 
-        expect(TokenType::CLOSE_BRACE, "at end of the scope", peek(-1).line, peek(-1).col);
+        expect(TokenType::CLOSE_BRACE, "at end of the scope", peek(-1));
         consume(); // consume '}'
 
-        return scope;
+        return arena_.make<ScopeNode>(takeNodes(base));
     }
 
 
@@ -240,24 +305,24 @@ private:
 
     // ===== EXPRESSION PARSE LOGIC =====
 
-    std::unique_ptr<ASTNode> parseExpression() {
+    ASTNode* parseExpression() {
         return parseComparison();
     }
 
-    std::unique_ptr<ASTNode> parseComparison() {
+    ASTNode* parseComparison() {
         auto left = parseAdditive();
         
         while (hasTokens() && isComparisonOperator(peek().type)) {
             Token op = consume();
             auto right = parseAdditive();
 
-            left = std::make_unique<BinaryOpNode>(op, std::move(left), std::move(right));
+            left = arena_.make<BinaryOpNode>(op, left, right);
         }
         
         return left;
     }
 
-    std::unique_ptr<ASTNode> parseAdditive() {
+    ASTNode* parseAdditive() {
         auto left = parseMultiplicative();
         
         while (hasTokens() && 
@@ -267,13 +332,13 @@ private:
             Token op = consume();
             auto right = parseMultiplicative();
 
-            left = std::make_unique<BinaryOpNode>(op, std::move(left), std::move(right));
+            left = arena_.make<BinaryOpNode>(op, left, right);
         }
         
         return left;
     }
 
-    std::unique_ptr<ASTNode> parseMultiplicative() {
+    ASTNode* parseMultiplicative() {
         auto left = parsePrimary();
         
         while (hasTokens() && 
@@ -283,15 +348,15 @@ private:
             Token op = consume();
             auto right = parsePrimary();
 
-            left = std::make_unique<BinaryOpNode>(op, std::move(left), std::move(right));
+            left = arena_.make<BinaryOpNode>(op, left, right);
         }
         
         return left;
     }
 
     // Parses expressions (number, string, variable)
-    std::unique_ptr<ASTNode> parsePrimary() {
-        if (!hasTokens()) error(false, 0, 0, "Expected expression");
+    ASTNode* parsePrimary() {
+        if (!hasTokens()) error(false, eofToken_, "Expected expression");
         
         Token tok = consume(); 
 
@@ -301,8 +366,11 @@ private:
             case TokenType::STRING_LIT:
             case TokenType::TRUE:
             case TokenType::FALSE:
+                return arena_.make<ExprNode>(tok);
+
+            // identifiers are interned once here, later phases only compare ids
             case TokenType::IDENT:
-                return std::make_unique<ExprNode>(tok);
+                return arena_.make<ExprNode>(tok, intern(source_.lexeme(tok)));
 
             // brackets
             case TokenType::OPEN_PAREN: {
@@ -319,65 +387,84 @@ private:
                 auto right = parsePrimary();
 
                 // expand it (-x) -> (0 - x)
-                return std::make_unique<BinaryOpNode>(
-                    Token{TokenType::MINUS, "-", tok.line, tok.col}, 
-                    std::make_unique<ExprNode>(Token{TokenType::INT_LIT, "0", tok.line, tok.col}),
-                    std::move(right)
+                if (!zeroToken_) zeroToken_ = source_.synthesize(TokenType::INT_LIT, "0");
+                return arena_.make<BinaryOpNode>(
+                    tok, // already '-'
+                    arena_.make<ExprNode>(*zeroToken_),
+                    right
                 );
             }
 
             default: {
-                error(true, tok.line, tok.col, "Invalid expression");
+                error(true, tok, "Invalid expression");
                 return nullptr;
             }
         }
 
 
         // should be unreachable -> left in case
-        error(true, tok.line, tok.col, "INTERNAL ERROR: Reached unreachable code in parseExpression");        
+        error(true, tok, "INTERNAL ERROR: Reached unreachable code in parseExpression");        
         return nullptr;
     }
 
     
     // ===== TOKEN PEEK/CONSUME LOGIC =====
+    // there is at least END_OF_FILE left
     bool hasTokens() const {
-        return pos_ < tokens_.size();
+        return pos_ <= eofPos_;
+    }
+
+    Token pull() {
+        if (tokenizer_) return tokenizer_->next();
+        return pulled_ < tokens_.size() ? tokens_[pulled_] : eofToken_;
     }
 
-    Token peek(size_t offset = 0) const {
-        if (pos_ + offset >= tokens_.size()) {
-            return Token{TokenType::END_OF_FILE, "", 0, 0};
+    // offset can be -1 (size_t wraps around) -> last consumed token
+    Token peek(size_t offset = 0) {
+        size_t idx = pos_ + offset;
+        if (idx > eofPos_ || idx == SIZE_MAX) return eofToken_; // past the end or before the first token
+
+        while (pulled_ <= idx) {
+            Token token = pull();
+            if (token.type == TokenType::END_OF_FILE && eofPos_ == SIZE_MAX) eofPos_ = pulled_;
+            window_[pulled_ % WINDOW] = token;
+            pulled_++;
         }
-        return tokens_[pos_ + offset];
+        return window_[idx % WINDOW];
     }
 
     Token consume() {
-        if (!hasTokens()) error(false, 0, 0, "Unexpected end of file");
-        return tokens_[pos_++];
+        if (!hasTokens()) error(false, eofToken_, "Unexpected end of file");
+        Token token = peek();
+        pos_++;
+        return token;
     }
 
     
     // ===== REPORT METHODS =====
 
     template<typename... Args>
-    [[noreturn]] void error(bool has_value, size_t line, size_t col, Args&&... args) {
+    [[noreturn]] void error(bool has_value, const Token& at, Args&&... args) {
         std::ostringstream oss;
         (oss << ... << args);
+        std::ostringstream text;
+        text << "Parser error: " << oss.str();
         if (has_value) {
-            std::cerr << "Parser error: " << oss.str() << " at line " << line << ", column " << col << std::endl;
-        } else {
-            std::cerr << "Parser error: " << oss.str() << std::endl;
+            SourcePos pos = source_.position(at);
+            text << " at line " << pos.line << ", column " << pos.col;
         }
-        exit(EXIT_FAILURE);
+        throw CompileError(text.str(), oss.str(), has_value ? at.offset : CompileError::NO_OFFSET, at.length);
     }
 
-    [[noreturn]] void error(const std::string& msg, Token token = Token{}) {
-        std::cerr << "Parser error: " << msg;
-        if (token.type != TokenType::END_OF_FILE) {
-            std::cerr << " at line " << token.line << ", col " << token.col;
+    [[noreturn]] void error(const std::string& msg, const Token& token = Token{}) {
+        std::ostringstream text;
+        text << "Parser error: " << msg;
+        bool hasPos = token.type != TokenType::END_OF_FILE;
+        if (hasPos) {
+            SourcePos pos = source_.position(token);
+            text << " at line " << pos.line << ", col " << pos.col;
         }
-        std::cerr << std::endl;
-        exit(EXIT_FAILURE);
+        throw CompileError(text.str(), msg, hasPos ? token.offset : CompileError::NO_OFFSET, token.length);
     }
 
     void expect(TokenType expected, const std::string& context) {
@@ -386,19 +473,26 @@ private:
         }
     }
 
-    void expect(TokenType expected, const std::string& context, size_t line, size_t col) {
+    void expect(TokenType expected, const std::string& context, const Token& at) {
         if (!hasTokens() || peek().type != expected) {
-            error("Expected '" + std::string(tokenTypeToString(expected)) + "' " + context, Token{.line = line, .col = col});
+            error("Expected '" + std::string(tokenTypeToString(expected)) + "' " + context, at);
         }
     }
 };
 
 // ========== WRAPPER ==========
-Parser::Parser(std::vector<Token> tokens, SimplifiedCommandRegistry& reg)
-    : pImpl(std::make_unique<Impl>(tokens, reg)) {}
+Parser::Parser(std::vector<Token> tokens, Source& source, SimplifiedCommandRegistry& reg, Arena& arena)
+    : pImpl(std::make_unique<Impl>(std::move(tokens), source, reg, arena)) {}
+
+Parser::Parser(Tokenizer& tokenizer, Source& source, SimplifiedCommandRegistry& reg, Arena& arena)
+    : pImpl(std::make_unique<Impl>(tokenizer, source, reg, arena)) {}
 
 Parser::~Parser() = default;  // Needed for unique_ptr<Impl>
 
-std::unique_ptr<ASTNode> Parser::parse() {
+ASTNode* Parser::parse() {
     return pImpl->parse();
+}
+
+ASTNode* Parser::parseNext(StatementStart* start) {
+    return pImpl->parseNext(start);
 }
\ No newline at end of file
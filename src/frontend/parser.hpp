@@ -1,19 +1,38 @@
 // frontend/parser.hpp
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <memory>
 
 class SimplifiedCommandRegistry;
+class Source;
+class Tokenizer;
+class Arena;
 struct Token;
 struct ASTNode;
 
+// where a top-level statement begins (see Parser::parseNext)
+struct StatementStart {
+    uint32_t text = 0;      // right after the token before it, 0 for the first one
+    uint32_t token = 0;     // its first token
+    bool separated = true;  // the token before it was a new line or ';' -> lexing can start over at text
+};
+
 class Parser {
 public:
-    Parser(const std::vector<Token> tokens, SimplifiedCommandRegistry& reg);
+    // nodes are allocated in the arena -> returned tree lives as long as the arena
+    Parser(std::vector<Token> tokens, Source& source, SimplifiedCommandRegistry& reg, Arena& arena);
+
+    // streaming -> tokens are pulled from the tokenizer while parsing, the full token vector never exists
+    Parser(Tokenizer& tokenizer, Source& source, SimplifiedCommandRegistry& reg, Arena& arena);
     ~Parser();
     
-    std::unique_ptr<ASTNode> parse();
+    ASTNode* parse();
+
+    // one top-level statement at a time (language server, see lsp/document.cpp), nullptr at the end
+    // start is filled before the statement is parsed -> it's valid even if parsing it throws
+    ASTNode* parseNext(StatementStart* start);
 
 private:
     // implementation
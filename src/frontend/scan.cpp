@@ -0,0 +1,201 @@
+// frontend/scan.cpp
+#include "./scan.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MCJAVA_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace scan {
+namespace {
+
+// ===== SCALAR =====
+// used as the fallback and for the tails shorter than one vector
+
+const char* skipIdentScalar(const char* p, const char* end) {
+    while (p < end && isIdentChar(*p)) p++;
+    return p;
+}
+
+const char* skipBlanksScalar(const char* p, const char* end) {
+    while (p < end && isBlank(*p)) p++;
+    return p;
+}
+
+const char* findEitherScalar(const char* p, const char* end, char a, char b) {
+    while (p < end && *p != a && *p != b) p++;
+    return p;
+}
+
+#ifdef MCJAVA_SCAN_X86
+
+// ===== SSE2 =====
+// signed compares only -> bytes >= 0x80 are negative, so they never fall into any ASCII range
+
+inline __m128i inRange16(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)), _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), v));
+}
+
+inline uint32_t identMask16(__m128i v) {
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20)); // 'A'..'Z' -> 'a'..'z'
+    __m128i m = _mm_or_si128(inRange16(lower, 'a', 'z'), inRange16(v, '0', '9'));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('-')));
+    return (uint32_t)_mm_movemask_epi8(m);
+}
+
+inline uint32_t blankMask16(__m128i v) {
+    // '\t' '\n' '\v' '\f' '\r' are 9..13, '\n' is excluded
+    __m128i m = _mm_andnot_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), inRange16(v, '\t', '\r'));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+    return (uint32_t)_mm_movemask_epi8(m);
+}
+
+const char* skipIdentSse2(const char* p, const char* end) {
+    for (; end - p >= 16; p += 16) {
+        uint32_t stop = ~identMask16(_mm_loadu_si128((const __m128i*)p)) & 0xFFFF;
+        if (stop) return p + __builtin_ctz(stop);
+    }
+    return skipIdentScalar(p, end);
+}
+
+const char* skipBlanksSse2(const char* p, const char* end) {
+    for (; end - p >= 16; p += 16) {
+        uint32_t stop = ~blankMask16(_mm_loadu_si128((const __m128i*)p)) & 0xFFFF;
+        if (stop) return p + __builtin_ctz(stop);
+    }
+    return skipBlanksScalar(p, end);
+}
+
+const char* findEitherSse2(const char* p, const char* end, char a, char b) {
+    const __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b);
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        uint32_t hit = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)));
+        if (hit) return p + __builtin_ctz(hit);
+    }
+    return findEitherScalar(p, end, a, b);
+}
+
+// ===== AVX2 =====
+// compiled for avx2 only inside this region, selected at runtime by cpuid
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+inline __m256i inRange32(__m256i v, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+}
+
+inline uint32_t identMask32(__m256i v) {
+    __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    __m256i m = _mm256_or_si256(inRange32(lower, 'a', 'z'), inRange32(v, '0', '9'));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('-')));
+    return (uint32_t)_mm256_movemask_epi8(m);
+}
+
+inline uint32_t blankMask32(__m256i v) {
+    __m256i m = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), inRange32(v, '\t', '\r'));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+    return (uint32_t)_mm256_movemask_epi8(m);
+}
+
+const char* skipIdentAvx2(const char* p, const char* end) {
+    for (; end - p >= 32; p += 32) {
+        uint32_t stop = ~identMask32(_mm256_loadu_si256((const __m256i*)p));
+        if (stop) return p + __builtin_ctz(stop);
+    }
+    return skipIdentScalar(p, end);
+}
+
+const char* skipBlanksAvx2(const char* p, const char* end) {
+    for (; end - p >= 32; p += 32) {
+        uint32_t stop = ~blankMask32(_mm256_loadu_si256((const __m256i*)p));
+        if (stop) return p + __builtin_ctz(stop);
+    }
+    return skipBlanksScalar(p, end);
+}
+
+const char* findEitherAvx2(const char* p, const char* end, char a, char b) {
+    const __m256i va = _mm256_set1_epi8(a), vb = _mm256_set1_epi8(b);
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        uint32_t hit = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb)));
+        if (hit) return p + __builtin_ctz(hit);
+    }
+    return findEitherScalar(p, end, a, b);
+}
+
+#pragma GCC pop_options
+
+#endif // MCJAVA_SCAN_X86
+
+
+// ===== DISPATCH =====
+
+struct Backend {
+    const char* name;
+    const char* (*skipIdent)(const char*, const char*);
+    const char* (*skipBlanks)(const char*, const char*);
+    const char* (*findEither)(const char*, const char*, char, char);
+};
+
+Backend selectBackend() {
+#ifdef MCJAVA_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return { "avx2", skipIdentAvx2, skipBlanksAvx2, findEitherAvx2 };
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return { "sse2", skipIdentSse2, skipBlanksSse2, findEitherSse2 };
+    }
+#endif
+    return { "scalar", skipIdentScalar, skipBlanksScalar, findEitherScalar };
+}
+
+const Backend& backend() {
+    static const Backend selected = selectBackend();
+    return selected;
+}
+
+} // namespace
+
+
+const char* skipIdent(const char* p, const char* end) {
+    return backend().skipIdent(p, end);
+}
+
+const char* skipBlanks(const char* p, const char* end) {
+    return backend().skipBlanks(p, end);
+}
+
+const char* findEither(const char* p, const char* end, char a, char b) {
+    return backend().findEither(p, end, a, b);
+}
+
+const char* findNewline(const char* p, const char* end) {
+    // memchr is already vectorized in every libc we care about
+    const void* hit = std::memchr(p, '\n', end - p);
+    return hit ? static_cast<const char*>(hit) : end;
+}
+
+const char* findBlockCommentEnd(const char* p, const char* end) {
+    while (p < end) {
+        const void* star = std::memchr(p, '*', end - p);
+        if (!star) return end;
+        p = static_cast<const char*>(star);
+        if (p + 1 < end && p[1] == '/') return p;
+        p++;
+    }
+    return end;
+}
+
+const char* backendName() {
+    return backend().name;
+}
+
+} // namespace scan
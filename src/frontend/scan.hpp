@@ -0,0 +1,39 @@
+// frontend/scan.hpp
+#pragma once
+
+#include <cstddef>
+
+// Bulk byte scanners used by the tokenizer.
+// Every function works on the half-open range [p, end) and returns the first position
+// that does NOT belong to the scanned run (or end). The implementation picks AVX2, SSE2
+// or a plain scalar loop at runtime, all of them return exactly the same results.
+namespace scan {
+
+    // [A-Za-z0-9_-] -> chars allowed after the first letter of an identifier
+    inline bool isIdentChar(unsigned char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+    }
+
+    // whitespace that doesn't produce any token (everything from isspace except '\n')
+    inline bool isBlank(unsigned char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    // skips run of identifier chars
+    const char* skipIdent(const char* p, const char* end);
+
+    // skips run of blanks (stops on '\n')
+    const char* skipBlanks(const char* p, const char* end);
+
+    // finds first 'a' or 'b', used for string bodies (quote or backslash)
+    const char* findEither(const char* p, const char* end, char a, char b);
+
+    // finds first '\n', used for line comments
+    const char* findNewline(const char* p, const char* end);
+
+    // finds first "*/", returns position of '*' or end
+    const char* findBlockCommentEnd(const char* p, const char* end);
+
+    // name of the selected implementation ("avx2", "sse2" or "scalar")
+    const char* backendName();
+}
@@ -1,63 +1,32 @@
 // frontend/tokenizer.cpp
 #include "./tokenizer.hpp"
 
+#include <cstring>
 #include <iostream>
-#include <unordered_map>
-#include <cctype>
 
 #include "./../registries/SimplifiedCommandRegistry.hpp"
 #include "./../core/token.hpp"
+#include "./../core/source.hpp"
+#include "./../core/diagnostic.hpp"
+#include "./scan.hpp"
+#include "./lexer_tables.hpp"
 
 
 
-const inline std::unordered_map<std::string, TokenType> KEYWORDS = {
-    {"while", TokenType::WHILE},
-    {"for", TokenType::FOR},
-    {"if", TokenType::IF},
-    {"else", TokenType::ELSE},
-    {"return", TokenType::RETURN},
-    {"true", TokenType::TRUE},
-    {"false", TokenType::FALSE},
-};
-
-const inline std::unordered_map<char, TokenType> CHARS = {
-    {'+', TokenType::PLUS},
-    {'-', TokenType::MINUS},
-    {'*', TokenType::MULTIPLY},
-    {'/', TokenType::DIVIDE},
-
-    {'=', TokenType::EQUALS},
-    {'<', TokenType::LESS},
-    {'>', TokenType::GREATER},
-
-    {'(', TokenType::OPEN_PAREN},
-    {')', TokenType::CLOSE_PAREN},
-    {'{', TokenType::OPEN_BRACE},
-    {'}', TokenType::CLOSE_BRACE},
-    {'[', TokenType::OPEN_BRACKET},
-    {']', TokenType::CLOSE_BRACKET},
-
-    {';', TokenType::SEMI_COLON},
-    {',', TokenType::COMMA},
-    {'.', TokenType::DOT},
-};
-
-const inline std::unordered_map<std::string, TokenType> DOUBLE_CHARS = {
-    {"==", TokenType::EQUALS_EQUALS},
-    {"!=", TokenType::NOT_EQUALS},
-    {"<=", TokenType::LESS_EQUAL},
-    {">=", TokenType::GREATER_EQUAL},
-};
-
-
 // Tokenizer implementation from ./tokenizer.hpp
 class Tokenizer::Impl {
 private:
-    size_t line = 1, col = 0;
-    std::string m_src;
+    Source& m_source;
+    std::string_view m_src;
     SimplifiedCommandRegistry& m_reg;
     size_t m_idx = 0;
 
+    std::string m_buf;              // only used for strings that have to be decoded
+    bool m_finalNewline = false;    // NEW_LINE for the last line without '\n' was already returned
+    bool m_regReady = false;        // registry loads on a background thread, waited for at the first identifier
+    bool m_rawCommand = false;      // last token was a command at the start of a statement -> rest of the line is its text
+    TokenType m_prevType = TokenType::NEW_LINE;
+
 
     inline std::optional<char> peek(int offset = 0) const 
     {
@@ -70,153 +39,266 @@ private:
 
     inline char consume() {
         // m_idx++ -> first get at m_idx then increment m_idx by 1
-        char c = m_src.at(m_idx++);
-        if (c == '\n') {  line++; col = 0; }
-        else col++;
-        return c;
+        return m_src[m_idx++];
+    }
+
+    inline const char* cursor() const { return m_src.data() + m_idx; }
+    inline const char* srcEnd() const { return m_src.data() + m_src.size(); }
+
+    // moves m_idx to the given pointer (returned by one of the scan:: functions)
+    inline void advanceTo(const char* p) { m_idx = p - m_src.data(); }
+
+    // token covering [start, m_idx)
+    inline Token make(TokenType type, size_t start) const {
+        return { .type = type, .offset = static_cast<uint32_t>(start), .length = static_cast<uint32_t>(m_idx - start) };
+    }
+
+    // the file is not normalized -> "\r\n" is turned into "\n" only where it matters (string values)
+    static void appendNormalized(std::string& out, std::string_view text) {
+        size_t cr;
+        while ((cr = text.find("\r\n")) != std::string_view::npos) {
+            out.append(text.substr(0, cr));
+            text.remove_prefix(cr + 1); // keep '\n'
+        }
+        out.append(text);
+    }
+
+    void waitForRegistry() {
+        std::string err;
+        if (!m_reg.wait(&err)) throw CompileError("cmd load error: " + err, "cmd load error: " + err);
+        m_regReady = true;
+    }
+
+    // line & column are only needed for errors -> resolved from the offset
+    [[noreturn]] void error(const std::string& msg) const {
+        SourcePos pos = m_source.position(static_cast<uint32_t>(m_idx));
+        std::string text = msg + " at line " + std::to_string(pos.line) + ", column " + std::to_string(pos.col);
+        throw CompileError(text, msg, static_cast<uint32_t>(m_idx), 1);
     }
     
 public:
-    Impl(const std::string& src, SimplifiedCommandRegistry& registry)
-        : m_src(src), m_reg(registry) {}
-    
+    Impl(Source& source, SimplifiedCommandRegistry& registry)
+        : m_source(source), m_src(source.text()), m_reg(registry) 
+    {
+        if (m_src.size() > Source::MAX_SIZE) {
+            std::string msg = "Source file is too large (" + std::to_string(m_src.size()) + " bytes)";
+            throw CompileError(msg, msg);
+        }
+    }
+
     std::vector<Token> tokenize() 
     {   
         std::vector<Token> tokens;
-        std::string buf;
+        do {
+            tokens.push_back(next());
+        } while (tokens.back().type != TokenType::END_OF_FILE);
+
+        m_idx = 0;
+        m_finalNewline = false;
+        m_rawCommand = false;
+        m_prevType = TokenType::NEW_LINE;
+        return tokens;
+    }
+
+    size_t offset() const { return m_idx; }
+
+    // returns next token, after the end of source always returns END_OF_FILE
+    Token next()
+    {
+        if (m_rawCommand) {
+            m_rawCommand = false;
+            Token text = rawCommandText();
+            if (text.length > 0) {
+                m_prevType = text.type;
+                return text;
+            }
+        }
+
+        Token token = lexNext();
+
+        // commands are passed to minecraft as they are written (validated by the parser),
+        // only say keeps its arguments as expressions (they are turned into tellraw)
+        if (token.type == TokenType::CMD_KEY && isStatementStart(m_prevType) && m_source.lexeme(token) != "say") {
+            m_rawCommand = true;
+        }
+        m_prevType = token.type;
+        return token;
+    }
+
+private:
+    static bool isStatementStart(TokenType prev) {
+        switch (prev) {
+            case TokenType::NEW_LINE:
+            case TokenType::SEMI_COLON:
+            case TokenType::OPEN_BRACE:
+            case TokenType::CLOSE_BRACE:
+            case TokenType::CLOSE_PAREN:    // if (...) cmd
+            case TokenType::ELSE:
+            case TokenType::ANNOTATION:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // rest of the line without surrounding whitespace, up to a ';' or "//" outside of quotes and [] {} ()
+    // (they may appear inside selectors, nbt and json) -> the terminator and comment are lexed as usual
+    Token rawCommandText() {
+        while (m_idx < m_src.size() && (m_src[m_idx] == ' ' || m_src[m_idx] == '\t')) m_idx++;
+        size_t start = m_idx;
+
+        const void* nl = std::memchr(cursor(), '\n', srcEnd() - cursor());
+        const char* lineEnd = nl ? static_cast<const char*>(nl) : srcEnd();
+        const char* end = cursor();
+        int depth = 0;
+        char quote = 0;
+        for (; end < lineEnd; end++) {
+            char c = *end;
+            if (quote) {
+                if (c == '\\' && end + 1 < lineEnd) end++;
+                else if (c == quote) quote = 0;
+                continue;
+            }
+            if (c == '"' || c == '\'') quote = c;
+            else if (c == '[' || c == '{' || c == '(') depth++;
+            else if ((c == ']' || c == '}' || c == ')') && depth > 0) depth--;
+            else if (depth == 0 && (c == ';' || (c == '/' && end + 1 < lineEnd && end[1] == '/'))) break;
+        }
+        while (end > cursor() && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) end--;
+
+        advanceTo(end);
+        return make(TokenType::COMMAND_TEXT, start);
+    }
+
+    Token lexNext()
+    {   
         while(peek().has_value()) {
 
             char value = peek().value();
+            size_t start = m_idx;
 
             // keywords & idents
-            if (std::isalpha(value)) {
-                size_t start_line = line, start_col = col;
-
-                buf.push_back(consume());
-                while (peek().has_value() &&
-                    (std::isalnum(peek().value()) || peek().value() == '_' || peek().value() == '-')) {
-                    buf.push_back(consume());
-                }
+            if (lex::is(value, lex::CC_ALPHA)) {
+                consume();
+                advanceTo(scan::skipIdent(cursor(), srcEnd()));
+                std::string_view word = m_src.substr(start, m_idx - start);
 
                 // check if word is keyword
-                auto it = KEYWORDS.find(buf);
-                if (it != KEYWORDS.end()) {
-                    tokens.push_back({ .type = it->second, .line = start_line, .col = start_col });
-                    
-                    buf.clear();
-                    continue;
+                TokenType keyword = lex::KEYWORDS.find(word, lex::NOT_FOUND);
+                if (keyword != lex::NOT_FOUND) {
+                    return make(keyword, start);
                 }
 
-                if (m_reg.isValid(buf)) {
-                    tokens.push_back({.type = TokenType::CMD_KEY, .value = buf, .line = start_line, .col = start_col });
+                if (!m_regReady) waitForRegistry();
+                if (m_reg.isValid(word)) {
+                    return make(TokenType::CMD_KEY, start);
                 } else {
-                    tokens.push_back({.type = TokenType::IDENT, .value = buf, .line = start_line, .col = start_col });
+                    return make(TokenType::IDENT, start);
                 } 
-
-                buf.clear();
-                continue;
             }
             
             // numbers
-            if (std::isdigit(value) ||
-                    (value == '-' && peek(1).has_value() && std::isdigit(peek(1).value())) ||
-                    (value == '.' && peek(1).has_value() && std::isdigit(peek(1).value())) ||
-                    (value == '-' && peek(1).has_value() && peek(1).value() == '.' && peek(2).has_value() && std::isdigit(peek(2).value())))
+            if (lex::is(value, lex::CC_DIGIT) ||
+                    (value == '-' && peek(1).has_value() && lex::is(peek(1).value(), lex::CC_DIGIT)) ||
+                    (value == '.' && peek(1).has_value() && lex::is(peek(1).value(), lex::CC_DIGIT)) ||
+                    (value == '-' && peek(1).has_value() && peek(1).value() == '.' && peek(2).has_value() && lex::is(peek(2).value(), lex::CC_DIGIT)))
             {
-                // reuse outer buf, already cleared
                 bool isFloat = false;
 
                 // optional minus
-                if (value == '-') buf.push_back(consume());
+                if (value == '-') consume();
 
                 // integer part
-                while (peek().has_value() && std::isdigit(peek().value()))
-                    buf.push_back(consume());
+                while (peek().has_value() && lex::is(peek().value(), lex::CC_DIGIT))
+                    consume();
 
                 // check if the value is float
                 if (peek().has_value() && peek().value() == '.') {
                     isFloat = true;
-                    buf.push_back(consume()); // consume '.'
-                    while (peek().has_value() && std::isdigit(peek().value())) {
-                        buf.push_back(consume());
+                    consume(); // consume '.'
+                    while (peek().has_value() && lex::is(peek().value(), lex::CC_DIGIT)) {
+                        consume();
                     }
                 }
 
-                if (isFloat) {
-                    tokens.push_back({ .type = TokenType::FLOAT_LIT,
-                                    .value = buf,
-                                    .line = line, .col = col });
-                } else {
-                    tokens.push_back({ .type = TokenType::INT_LIT,
-                                    .value = buf,
-                                    .line = line, .col = col });
-                }
-
-                buf.clear();
-                continue;
+                return make(isFloat ? TokenType::FLOAT_LIT : TokenType::INT_LIT, start);
             }
 
             // strings 
             if (value == '"' || value == '\'') {
                 char quote = consume(); // consume " or '
-                while (peek().has_value() && peek().value() != quote) {
-                    char c = consume();
-                    if (c == '\\') { // escape sequence
-                        if (!peek().has_value()) {
-                            std::cerr << "Unterminated escape sequence in string at line " << line << ", column " << col << std::endl;
-                            exit(EXIT_FAILURE);
-                        }
-                        char esc = consume();
-                        switch (esc) {
-                            case 'n': buf.push_back('\n'); break;
-                            case 'r': buf.push_back('\r'); break;
-                            case 't': buf.push_back('\t'); break;
-                            case '\\': buf.push_back('\\'); break;
-                            case '\'': buf.push_back('\''); break;
-                            case '"': buf.push_back('"'); break;
-                            default:
-                                std::cerr << "Unknown escape sequence \\" << esc << " at line " << line << ", column " << col << std::endl;
-                                exit(EXIT_FAILURE);
-                        }
-                    } else {
-                        buf.push_back(c);
+                size_t bodyStart = m_idx;
+                bool hasEscapes = false;
+
+                while (true) {
+                    // skip everything up to the closing quote or escape sequence at once
+                    const char* stop = scan::findEither(cursor(), srcEnd(), quote, '\\');
+                    if (hasEscapes) appendNormalized(m_buf, std::string_view(cursor(), stop - cursor()));
+                    advanceTo(stop);
+
+                    if (!peek().has_value() || peek().value() == quote) break;
+
+                    // first escape sequence -> from now on the value is decoded into m_buf
+                    if (!hasEscapes) {
+                        hasEscapes = true;
+                        m_buf.clear();
+                        appendNormalized(m_buf, m_src.substr(bodyStart, m_idx - bodyStart));
+                    }
+
+                    consume(); // consume '\\'
+                    if (!peek().has_value()) error("Unterminated escape sequence in string");
+
+                    char esc = consume();
+                    switch (esc) {
+                        case 'n': m_buf.push_back('\n'); break;
+                        case 'r': m_buf.push_back('\r'); break;
+                        case 't': m_buf.push_back('\t'); break;
+                        case '\\': m_buf.push_back('\\'); break;
+                        case '\'': m_buf.push_back('\''); break;
+                        case '"': m_buf.push_back('"'); break;
+                        default:
+                            error(std::string("Unknown escape sequence \\") + esc);
                     }
                 }
 
-                if (!peek().has_value()) {
-                    std::cerr << "Unterminated string literal! at line " << line << ", column " << col << std::endl;
-                    exit(EXIT_FAILURE);
+                if (!peek().has_value()) error("Unterminated string literal!");
+
+                // multiline string written with CRLF line endings
+                if (!hasEscapes && m_src.substr(bodyStart, m_idx - bodyStart).find("\r\n") != std::string_view::npos) {
+                    hasEscapes = true;
+                    m_buf.clear();
+                    appendNormalized(m_buf, m_src.substr(bodyStart, m_idx - bodyStart));
+                }
+
+                Token token;
+                if (hasEscapes) {
+                    // decoded value doesn't exist in the source text
+                    token = m_source.synthesize(TokenType::STRING_LIT, m_buf);
+                    m_buf.clear();
+                } else {
+                    token = make(TokenType::STRING_LIT, bodyStart);
                 }
 
                 consume(); // skip closing quote
-                tokens.push_back({ .type = TokenType::STRING_LIT, .value = buf, .line = line, .col = col });
-                buf.clear();
-                continue;
+                return token;
             }
 
             // annotations
             if (value == '@') {
                 consume(); // consume '@'
-                while (peek().has_value() && (std::isalnum(peek().value()) || peek().value() == '_')) {
-                    buf.push_back(consume());
+                while (peek().has_value() && lex::is(peek().value(), lex::CC_ANNOTATION)) {
+                    consume();
                 }
 
-                if (buf.empty()) {
-                    std::cerr << "Empty annotation name at line " << line << ", column " << col << std::endl;
-                    exit(EXIT_FAILURE);
-                }
+                if (m_idx - start == 1) error("Empty annotation name");
 
-                tokens.push_back({ .type = TokenType::ANNOTATION, .value = buf, .line = line, .col = col });
-                buf.clear();
-                continue;
+                return make(TokenType::ANNOTATION, start + 1); // name without '@'
             }
 
             // comments
-            if (value == '#' && col == 0) {
+            if (value == '#' && (m_idx == 0 || m_src[m_idx - 1] == '\n')) { // only at the start of the line
                 consume(); //  consume '#'
-                while (peek().has_value() && peek().value() != '\n') {
-                    consume();
-                }
+                advanceTo(scan::findNewline(cursor(), srcEnd()));
                 continue;
             }
 
@@ -226,9 +308,7 @@ public:
                 if (value == '/' && value2 == '/') {
                     consume(); // consume '/'
                     consume(); // consume '/'
-                    while (peek().has_value() && peek().value() != '\n') {
-                        consume();
-                    }
+                    advanceTo(scan::findNewline(cursor(), srcEnd()));
                     continue;
                 }
     
@@ -236,72 +316,72 @@ public:
                     consume(); // consume '/'
                     consume(); // consume '*'
 
-                    while (peek().has_value() && !(peek().value() == '*' && peek(1).has_value() && peek(1).value() == '/')) {
-                        consume();
-                    }
+                    advanceTo(scan::findBlockCommentEnd(cursor(), srcEnd()));
                     
-                    if (!peek().has_value()) {
-                        std::cerr << "Unterminated block comment at line " << line << ", column " << col << std::endl;
-                        exit(EXIT_FAILURE);
-                    }
+                    if (!peek().has_value()) error("Unterminated block comment");
                     
-                    // we made sure that the next 2 chars are '*' and '/' -> while condition is defining it
+                    // we made sure that the next 2 chars are '*' and '/' -> findBlockCommentEnd stops only there
                     consume(); // consume '*'
                     consume(); // consume '/'
                     continue;
                 }
     
                 // check for double char tokens
-                std::string doubleChar;
-                doubleChar += value;
-                doubleChar += value2;
-
-                auto it = DOUBLE_CHARS.find(doubleChar);
-                if (it != DOUBLE_CHARS.end()) {
-                    consume(); // consume the first character of DOUBLE_CHAR
-                    consume(); // consume the secon character of DOUBLE_CHAR
-                    
-                    tokens.push_back({ .type = it->second, .value = doubleChar, .line = line, .col = col });
-                    
-                    buf.clear();
-                    continue;
+                if (lex::is(value, lex::CC_DOUBLE_START)) {
+                    TokenType op = lex::DOUBLE_CHARS.find(m_src.substr(m_idx, 2), lex::NOT_FOUND);
+                    if (op != lex::NOT_FOUND) {
+                        consume(); // consume the first character of DOUBLE_CHAR
+                        consume(); // consume the secon character of DOUBLE_CHAR
+                        
+                        return make(op, start);
+                    }
                 }
             }
 
             // check for single char tokens
-            auto it = CHARS.find(value);
-            if (it != CHARS.end()) {
+            const lex::CharInfo& info = lex::CHAR_TABLE[(unsigned char)value];
+            if (info.cls & lex::CC_SINGLE) {
                 consume();
-                
-                std::string str(1, value);
-                tokens.push_back({ .type = it->second, .value = str, .line = line, .col = col });
-                continue;
+                return make(info.single, start);
             }
 
             // new line
-            if (std::isspace(value)) {
-                if (peek().value() == '\n') tokens.push_back({.type = TokenType::NEW_LINE, .line = line, .col = col });
+            if (value == '\n') {
                 consume();
+                return make(TokenType::NEW_LINE, start);
+            }
+
+            // other whitespace -> skip the whole run at once
+            if (info.cls & lex::CC_SPACE) {
+                advanceTo(scan::skipBlanks(cursor(), srcEnd()));
                 continue;
             } else {
-                std::cerr << "Unidentified value \'" << peek().value() << "\'! at line " << line << ", column " << col << std::endl;
-                exit(EXIT_FAILURE);
+                error(std::string("Unidentified value \'") + value + "\'!");
             }
         }
-        tokens.push_back({.type = TokenType::END_OF_FILE, .line = line, .col = col });
-        m_idx = 0;
-        line = 1;
-        col = 0;
-        return tokens;
+        // last line without '\n' still ends with NEW_LINE
+        if (!m_finalNewline && !m_src.empty() && m_src.back() != '\n') {
+            m_finalNewline = true;
+            return make(TokenType::NEW_LINE, m_idx);
+        }
+
+        return make(TokenType::END_OF_FILE, m_idx);
     }
 };
 
 // ========== WRAPPER ==========
-Tokenizer::Tokenizer(const std::string& source, SimplifiedCommandRegistry& registry)
+Tokenizer::Tokenizer(Source& source, SimplifiedCommandRegistry& registry)
     : pImpl(std::make_unique<Impl>(source, registry)) {}
 
 Tokenizer::~Tokenizer() = default;  // Needed for unique_ptr<Impl>
 
 std::vector<Token> Tokenizer::tokenize() {
     return pImpl->tokenize();
-}
\ No newline at end of file
+}
+
+Token Tokenizer::next() {
+    return pImpl->next();
+}
+size_t Tokenizer::offset() const {
+    return pImpl->offset();
+}
@@ -7,15 +7,23 @@
 #include <memory>
 
 class SimplifiedCommandRegistry;
+class Source;
 struct Token; 
 
 class Tokenizer {
 public:
-    Tokenizer(const std::string& src, SimplifiedCommandRegistry& registry);
+    Tokenizer(Source& source, SimplifiedCommandRegistry& registry);
     ~Tokenizer();
     
+    // whole source at once (used for -dump-tokens)
     std::vector<Token> tokenize();
 
+    // pull one token at a time, after the end keeps returning END_OF_FILE
+    Token next();
+
+    // how far the source has been read (a token that was lexed may reach past the ones parsed so far)
+    size_t offset() const;
+
 private:
     // implementation
     class Impl;
@@ -0,0 +1,647 @@
+// lsp/document.cpp
+#include "./document.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "./../frontend/tokenizer.hpp"
+#include "./../frontend/parser.hpp"
+#include "./../middleend/resolver.hpp"
+#include "./../middleend/analyzer.hpp"
+#include "./../core/ast.hpp"
+#include "./../core/diagnostic.hpp"
+#include "./../core/unit.hpp"
+#include "./../core/visitor.hpp"
+
+namespace {
+
+    // value of a top-level variable after a statement, owns its text -> outlives the VarPool it was analyzed in
+    struct Export {
+        SymbolId name;
+        bool hasValue = false;  // false -> declared, but the statement failed before assigning it
+        DataType dataType = DataType::UNKNOWN;
+        bool isConstant = false;
+        Constant::Kind kind = Constant::Kind::NONE;
+        int32_t value = 0;
+        std::string text;
+
+        bool operator==(const Export&) const = default;
+
+        // the variable as the next statements see it
+        VarInfo info() const {
+            return {
+                .name           = name,
+                .dataType       = dataType,
+                .isConstant     = isConstant,
+                .constValue     = { .kind = kind, .value = value, .text = text },
+                .storageType    = VarStorageType::SCOREBOARD,
+                .storageIdent   = name,
+                .storagePath    = name,
+                .isUsed         = true,
+                .isInitialized  = true,
+            };
+        }
+    };
+
+    // error of one statement, offset is relative to the statement's start
+    struct LocalError {
+        uint32_t offset;
+        uint32_t length;
+        std::string message;
+    };
+
+    // variables a statement reads or writes, after resolving also which name got which slot of the root scope
+    class Names : public ASTVisitor<Names> {
+    public:
+        std::vector<SymbolId> names;
+        std::vector<SymbolId>* rootSlots = nullptr;
+
+        void visitCommand(const CommandNode& node) {
+            for (const ASTNode* arg : node.args) visit(*arg);
+        }
+
+        void visitVarDecl(const VarDeclNode& node) {
+            visit(*node.value);
+            names.push_back(node.symbol);
+            if (rootSlots && node.binding.scope == 0 && node.binding.slot < rootSlots->size()) (*rootSlots)[node.binding.slot] = node.symbol;
+        }
+
+        void visitExpr(const ExprNode& node) {
+            if (node.token.type == TokenType::IDENT) names.push_back(node.symbol);
+        }
+
+        void visitBinaryOp(const BinaryOpNode& node) {
+            visit(*node.left);
+            visit(*node.right);
+        }
+
+        void visitIf(const IfNode& node) {
+            visit(*node.condition);
+            visit(*node.thenBranch);
+            if (node.elseBranch) visit(*node.elseBranch);
+        }
+
+        void visitWhile(const WhileNode& node) {
+            visit(*node.condition);
+            visit(*node.body);
+        }
+
+        void visitScope(const ScopeNode& node) {
+            for (const ASTNode* stmt : node.statements) visit(*stmt);
+        }
+    };
+
+    // line ends with a statement separator (spaces after it don't matter)
+    bool endsClean(std::string_view text) {
+        size_t last = text.find_last_not_of(" \t\r");
+        return last == std::string_view::npos || text[last] == '\n' || text[last] == ';';
+    }
+
+    // start of the line with the last non blank character
+    uint32_t lastLineStart(std::string_view text) {
+        size_t last = text.find_last_not_of(" \t\r\n");
+        if (last == std::string_view::npos) return 0;
+        size_t nl = text.rfind('\n', last);
+        return nl == std::string_view::npos ? 0 : nl + 1;
+    }
+
+    uint32_t nextLine(std::string_view text, uint32_t at) {
+        size_t nl = text.find('\n', at);
+        return nl == std::string_view::npos ? text.size() : nl + 1;
+    }
+
+    // utf-16 code units of utf-8 text
+    uint32_t utf16Length(std::string_view text) {
+        uint32_t units = 0;
+        for (unsigned char c : text) {
+            if ((c & 0xC0) != 0x80) units++;    // every code point but the continuation bytes
+            if ((c & 0xF8) == 0xF0) units++;    // 4 byte sequence -> surrogate pair
+        }
+        return units;
+    }
+}
+
+
+class Document::Impl {
+public:
+    Impl(SimplifiedCommandRegistry& reg, Options& options, std::string text, bool utf16)
+        : reg_(reg), options_(options), utf16_(utf16) {
+        replace(std::move(text));
+    }
+
+    void replace(std::string text) {
+        text_ = std::move(text);
+        stats_ = {};
+
+        statements_.clear();
+        parseRegion(0, text_.size(), {}, false, statements_);
+        if (statements_.empty()) statements_.push_back(emptyStatement());
+
+        Env env(statements_, 0);
+        for (auto& st : statements_) {
+            analyze(*st, env);
+            env.apply(*st);
+        }
+        stats_.statements = statements_.size();
+    }
+
+    void edit(TextPos startPos, TextPos endPos, std::string_view text) {
+        stats_ = {};
+        uint32_t start = offsetOf(startPos);
+        uint32_t end = std::max(start, offsetOf(endPos));
+
+        // damaged statements -> everything the edited range touches, including the one right before it
+        // (text typed at the start of a statement can join it with the previous one)
+        size_t first = indexAt(start == 0 ? 0 : start - 1);
+        size_t last = indexAt(end);
+        for (size_t i = first; i-- > 0;) {
+            if (statements_[i]->reach > start) first = i; // its string or comment runs into the edit
+        }
+
+        text_.replace(start, end - start, text);
+        const int64_t delta = int64_t(text.size()) - int64_t(end - start);
+
+        // broken statements next to it may be fixed by the edit (closing brace, end of a comment)
+        // and lexing has to start over where nothing from the statement before continues
+        auto widen = [&] {
+            while (first > 0 && (statements_[first]->glued || statements_[first - 1]->broken)) first--;
+            while (last + 1 < statements_.size() && (statements_[last + 1]->glued || statements_[last + 1]->broken)) last++;
+        };
+        widen();
+
+        // the new text must end between two statements, otherwise the region grows until it does
+        // (twice as many statements every time -> an unclosed brace costs a few passes, not one per line)
+        Statements fresh;
+        uint32_t regionEnd;
+        while (true) {
+            const Statement& head = *statements_[first];
+            bool more = last + 1 < statements_.size();
+            regionEnd = more ? uint32_t(statements_[last + 1]->start + delta) : text_.size();
+
+            fresh.clear();
+            if (parseRegion(head.start, regionEnd, { head.start, head.line, head.col }, more, fresh)) break;
+
+            last = std::min(statements_.size() - 1, last + (last - first + 1));
+            widen();
+        }
+
+        // statements after the region only move
+        Cursor at = { statements_[first]->start, statements_[first]->line, statements_[first]->col };
+        advance(at, regionEnd);
+        if (last + 1 < statements_.size()) {
+            const Statement& next = *statements_[last + 1];
+            const int64_t lineDelta = int64_t(at.line) - next.line;
+            const int64_t colDelta = int64_t(at.col) - next.col;
+            const uint32_t sameLine = next.line;
+
+            for (size_t i = last + 1; i < statements_.size(); i++) {
+                Statement& st = *statements_[i];
+                if (st.line == sameLine) st.col += colDelta; // statements after ';' on the edited line
+                st.start += delta;
+                st.reach += delta;
+                st.line += lineDelta;
+            }
+        }
+
+        Statements removed;
+        removed.reserve(last - first + 1);
+        std::move(statements_.begin() + first, statements_.begin() + last + 1, std::back_inserter(removed));
+        statements_.erase(statements_.begin() + first, statements_.begin() + last + 1);
+        size_t count = fresh.size();
+        statements_.insert(statements_.begin() + first, std::make_move_iterator(fresh.begin()), std::make_move_iterator(fresh.end()));
+        if (statements_.empty()) {
+            statements_.push_back(emptyStatement());
+            count = 1;
+        }
+
+        reanalyze(first, count, removed);
+        stats_.statements = statements_.size();
+    }
+
+    std::vector<Diagnostic> diagnostics() const {
+        std::vector<Diagnostic> result;
+        for (size_t i = 0; i < statements_.size(); i++) {
+            const Statement& st = *statements_[i];
+            if (st.parseError) result.push_back(diagnostic(i, *st.parseError));
+            if (st.analysisError) result.push_back(diagnostic(i, *st.analysisError));
+        }
+        return result;
+    }
+
+    std::string_view text() const {
+        return text_;
+    }
+
+    Stats stats() const {
+        return stats_;
+    }
+
+private:
+    // one top-level statement and the text after it up to the next one
+    struct Statement {
+        uint32_t start;                         // offset in the document, right after the statement before it
+        uint32_t line, col;                     // position of start, col in bytes
+        bool glued = false;                     // no new line or ';' before it -> it can't be lexed on its own
+        uint32_t reach = 0;                     // offset the lexer got to while parsing it, a string or comment may go on
+                                                // past the statements after it -> edits up to there change it too
+
+        std::shared_ptr<CompilationUnit> unit;  // region it was parsed in -> tokens of root point into unit->source
+        uint32_t base;                          // where start is in unit->source
+        uint32_t lead;                          // first token, relative to start (blank lines & comments before it)
+
+        ASTNode* root = nullptr;                // the statement wrapped in a scope, nullptr if broken or blank
+        bool broken = false;
+        std::optional<LocalError> parseError;
+        std::optional<LocalError> analysisError;
+
+        std::vector<SymbolId> names;            // variables it reads or writes, sorted
+        std::vector<Export> exports;            // top-level variables it declared or changed
+
+        const Export* find(SymbolId name) const {
+            for (const Export& e : exports) {
+                if (e.name == name) return &e;
+            }
+            return nullptr;
+        }
+    };
+
+    using Statements = std::vector<std::unique_ptr<Statement>>;
+
+    struct Parsed {
+        StatementStart start;
+        ASTNode* stmt;
+        uint32_t reach; // relative to the region
+    };
+
+    struct Cursor {
+        uint32_t offset = 0;
+        uint32_t line = 0;
+        uint32_t col = 0;
+    };
+
+    // values of top-level variables at one statement, looked up only for the names that are used
+    class Env {
+    public:
+        // origin -> first statement that will be analyzed (& applied), names are looked up in the statements before it
+        Env(const Statements& statements, size_t origin) : statements_(statements), origin_(origin) {}
+
+        // nullptr -> doesn't exist yet
+        const Export* find(SymbolId name) {
+            auto [it, isNew] = values_.try_emplace(name.id, nullptr);
+            if (isNew) {
+                for (size_t i = origin_; i-- > 0;) {
+                    if (const Export* e = statements_[i]->find(name)) {
+                        it->second = e;
+                        break;
+                    }
+                }
+            }
+            return it->second;
+        }
+
+        void apply(const Statement& st) {
+            for (const Export& e : st.exports) values_[e.name.id] = &e;
+        }
+
+    private:
+        const Statements& statements_;
+        const size_t origin_;
+        std::unordered_map<uint32_t, const Export*> values_;
+    };
+
+    SimplifiedCommandRegistry& reg_;
+    Options& options_;
+    const bool utf16_;
+
+    std::string text_;
+    Statements statements_; // always at least one, the first one starts at 0
+    Resolver resolver_;
+    Stats stats_;
+
+
+    // ===== PARSING =====
+
+    // [from, to) into statements, at is the position of from
+    // extend -> false is returned if the text ends in the middle of a statement (the caller adds more text)
+    bool parseRegion(uint32_t from, uint32_t to, Cursor at, bool extend, Statements& out) {
+        while (true) {
+            stats_.reparsed += to - from;
+
+            // the region gets its own source -> tokens and nodes of statements outside of it are left alone
+            auto unit = std::shared_ptr<CompilationUnit>(new CompilationUnit{ .source = Source(text_.substr(from, to - from)) });
+            std::string_view local = unit->source.text();
+
+            Tokenizer tokenizer(unit->source, reg_);
+            Parser parser(tokenizer, unit->source, reg_, unit->arena);
+
+            std::vector<Parsed> parsed;
+            std::optional<CompileError> error;
+            StatementStart next;
+            try {
+                while (true) {
+                    next.token = UINT32_MAX; // stays if the error comes before the statement's first token
+                    ASTNode* stmt = parser.parseNext(&next);
+                    if (!stmt) break;
+                    parsed.push_back({ next, stmt, uint32_t(tokenizer.offset()) });
+                }
+            } catch (const CompileError& e) {
+                error = e;
+            }
+
+            if (!error) {
+                if (extend && !endsClean(local)) return false;
+                emit(unit, from, parsed, at, out);
+                if (parsed.empty() && !local.empty()) {
+                    out.push_back(makeStatement(unit, from, {}, nullptr, at));
+                    out.back()->reach = from + tokenizer.offset();
+                }
+                return true;
+            }
+
+            // error on the last line may only be the end of the region cutting a statement
+            uint32_t errorAt = error->offset == CompileError::NO_OFFSET || error->offset >= local.size() ? local.size() : error->offset;
+            bool atEnd = errorAt >= lastLineStart(local);
+            if (atEnd && extend) return false;
+
+            // panic mode -> the broken statement ends with the error's line, the rest is parsed on its own
+            StatementStart failed = next;
+            if (next.token == UINT32_MAX) {
+                // lexing failed on the way to the next statement (comment or string left open)
+                // -> the broken one takes everything the lexer read after the last good statement
+                uint32_t after = parsed.empty() ? 0 : parsed.back().reach;
+                failed = { .text = after, .token = after, .separated = false };
+            }
+            while (!parsed.empty() && parsed.back().start.text >= failed.text) parsed.pop_back();
+            if (parsed.empty()) {
+                failed.text = 0;
+                failed.separated = true;
+            }
+            uint32_t brokenEnd = atEnd ? local.size() : nextLine(local, std::max(errorAt, failed.text));
+
+            emit(unit, from, parsed, at, out);
+            auto broken = makeStatement(unit, from, failed, nullptr, at);
+            broken->broken = true;
+            broken->reach = from + tokenizer.offset();
+            bool known = error->offset != CompileError::NO_OFFSET && errorAt >= failed.text;
+            broken->parseError = LocalError{ known ? errorAt - failed.text : broken->lead, known ? error->length : 0, error->message };
+            out.push_back(std::move(broken));
+
+            if (brokenEnd >= local.size()) return true;
+            from += brokenEnd;
+        }
+    }
+
+    // statements parsed from unit, each one ends where the next one starts
+    void emit(const std::shared_ptr<CompilationUnit>& unit, uint32_t from, const std::vector<Parsed>& parsed, Cursor& at, Statements& out) {
+        for (size_t i = 0; i < parsed.size(); i++) {
+            StatementStart start = parsed[i].start;
+            if (i == 0) start.text = 0; // text before the first statement belongs to it
+
+            ASTNode* stmt = parsed[i].stmt;
+            ASTNode* root = unit->arena.make<ScopeNode>(unit->arena.copy(&stmt, 1));
+            out.push_back(makeStatement(unit, from, start, root, at));
+            out.back()->reach = from + parsed[i].reach;
+        }
+    }
+
+    // start is relative to from
+    std::unique_ptr<Statement> makeStatement(const std::shared_ptr<CompilationUnit>& unit, uint32_t from, StatementStart start, ASTNode* root, Cursor& at) {
+        auto st = std::make_unique<Statement>();
+        st->start = from + start.text;
+        advance(at, st->start);
+        st->line = at.line;
+        st->col = at.col;
+        st->glued = !start.separated;
+        st->unit = unit;
+        st->base = start.text;
+        st->lead = start.token - start.text;
+        st->root = root;
+
+        if (root) {
+            Names names;
+            names.visit(*root);
+            std::sort(names.names.begin(), names.names.end(), [](SymbolId a, SymbolId b) { return a.id < b.id; });
+            names.names.erase(std::unique(names.names.begin(), names.names.end()), names.names.end());
+            st->names = std::move(names.names);
+        }
+        return st;
+    }
+
+    std::unique_ptr<Statement> emptyStatement() {
+        auto unit = std::shared_ptr<CompilationUnit>(new CompilationUnit{});
+        Cursor at;
+        return makeStatement(unit, 0, {}, nullptr, at);
+    }
+
+
+    // ===== ANALYSIS =====
+
+    // statements [first, first + count) are new, removed are the ones they replaced
+    // -> only statements after them that use a variable whose value changed are analyzed again
+    void reanalyze(size_t first, size_t count, const Statements& removed) {
+        std::unordered_map<uint32_t, const Export*> before, after; // last value each statement set
+        for (const auto& st : removed) {
+            for (const Export& e : st->exports) before[e.name.id] = &e;
+        }
+
+        Env env(statements_, first);
+        for (size_t i = first; i < first + count; i++) {
+            analyze(*statements_[i], env);
+            env.apply(*statements_[i]);
+            for (const Export& e : statements_[i]->exports) after[e.name.id] = &e;
+        }
+
+        std::unordered_set<uint32_t> changed;
+        for (const auto& [id, e] : before) {
+            auto it = after.find(id);
+            if (it == after.end() || !(*it->second == *e)) changed.insert(id);
+        }
+        for (const auto& [id, e] : after) {
+            if (!before.count(id)) changed.insert(id);
+        }
+
+        for (size_t i = first + count; i < statements_.size() && !changed.empty(); i++) {
+            Statement& st = *statements_[i];
+            bool uses = std::any_of(st.names.begin(), st.names.end(), [&](SymbolId name) { return changed.count(name.id); });
+
+            if (!uses) {
+                // its values don't depend on the change -> after it those variables are the same as before
+                for (const Export& e : st.exports) changed.erase(e.name.id);
+            } else {
+                std::vector<Export> old = std::move(st.exports);
+                analyze(st, env);
+
+                auto update = [&](SymbolId name) {
+                    const Export* was = nullptr;
+                    for (const Export& e : old) {
+                        if (e.name == name) was = &e;
+                    }
+                    const Export* now = st.find(name);
+                    if (was && now && *was == *now) changed.erase(name.id);
+                    else changed.insert(name.id);
+                };
+                for (const Export& e : old) update(e.name);
+                for (const Export& e : st.exports) update(e.name);
+            }
+            env.apply(st);
+        }
+    }
+
+    void analyze(Statement& st, Env& env) {
+        stats_.reanalyzed++;
+        st.analysisError.reset();
+        st.exports.clear();
+        if (!st.root) return;
+
+        // variables of earlier statements take the first slots of the root scope
+        VarPool vars;
+        std::vector<SymbolId> names;
+        std::vector<VarId> values;
+        for (SymbolId name : st.names) {
+            const Export* e = env.find(name);
+            if (!e) continue;
+            names.push_back(name);
+            values.push_back(e->hasValue ? vars.add(e->info()) : NO_VAR);
+        }
+
+        resolver_.resolve(*st.root, names);
+        Analyzer analyzer(options_, st.unit->source, vars);
+        try {
+            analyzer.analyze(*st.root, values);
+        } catch (const CompileError& e) {
+            bool known = e.offset != CompileError::NO_OFFSET && !st.unit->source.isSynthetic(e.offset) && e.offset >= st.base;
+            st.analysisError = LocalError{ known ? e.offset - st.base : st.lead, known ? e.length : 0, e.message };
+        }
+
+        // root slots that changed -> values the next statements see (a failed statement exports what it got to)
+        auto scopes = analyzer.getScopes();
+        if (scopes.empty() || !scopes[0]) return;
+        const std::vector<VarId>& slots = scopes[0]->slots;
+
+        std::vector<SymbolId> slotNames(slots.size());
+        std::copy(names.begin(), names.end(), slotNames.begin());
+        Names declared;
+        declared.rootSlots = &slotNames;
+        declared.visit(*st.root);
+
+        for (size_t k = 0; k < slots.size(); k++) {
+            if (k < values.size() && slots[k] == values[k]) continue;
+
+            Export e = { .name = slotNames[k], .hasValue = slots[k] != NO_VAR };
+            if (e.hasValue) {
+                const VarInfo& info = vars[slots[k]];
+                e.dataType = info.dataType;
+                e.isConstant = info.isConstant;
+                e.kind = info.constValue.kind;
+                e.value = info.constValue.value;
+                e.text = info.constValue.text;
+            }
+            st.exports.push_back(std::move(e));
+        }
+    }
+
+
+    // ===== POSITIONS =====
+
+    // statement containing offset
+    size_t indexAt(uint32_t offset) const {
+        auto it = std::upper_bound(statements_.begin(), statements_.end(), offset, [](uint32_t off, const auto& st) { return off < st->start; });
+        return it == statements_.begin() ? 0 : (it - statements_.begin()) - 1;
+    }
+
+    void advance(Cursor& at, uint32_t to) const {
+        std::string_view part(text_.data() + at.offset, to - at.offset);
+        size_t lines = std::count(part.begin(), part.end(), '\n');
+        if (lines > 0) {
+            at.line += lines;
+            at.col = part.size() - part.rfind('\n') - 1;
+        } else {
+            at.col += part.size();
+        }
+        at.offset = to;
+    }
+
+    uint32_t offsetOf(TextPos pos) const {
+        // the line starts after the last statement that starts on an earlier line
+        auto it = std::partition_point(statements_.begin(), statements_.end(), [&](const auto& st) { return st->line < pos.line; });
+        uint32_t at = 0, line = 0;
+        if (it != statements_.begin()) {
+            at = (*std::prev(it))->start;
+            line = (*std::prev(it))->line;
+        }
+
+        while (line < pos.line) {
+            size_t nl = text_.find('\n', at);
+            if (nl == std::string::npos) return text_.size();
+            at = nl + 1;
+            line++;
+        }
+
+        size_t lineEnd = text_.find('\n', at);
+        if (lineEnd == std::string::npos) lineEnd = text_.size();
+        if (!utf16_) return std::min<size_t>(at + pos.character, lineEnd);
+
+        for (uint32_t units = 0; at < lineEnd && units < pos.character;) {
+            unsigned char c = text_[at];
+            size_t length = c < 0x80 ? 1 : (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : 4;
+            units += length == 4 ? 2 : 1;
+            at += length;
+        }
+        return std::min<size_t>(at, lineEnd);
+    }
+
+    // offset inside statement i (or right at its end)
+    TextPos positionOf(size_t i, uint32_t offset) const {
+        const Statement& st = *statements_[i];
+        std::string_view part(text_.data() + st.start, offset - st.start);
+
+        uint32_t line = st.line + std::count(part.begin(), part.end(), '\n');
+        size_t nl = part.rfind('\n');
+        uint32_t lineBegin = nl == std::string_view::npos ? st.start - st.col : st.start + nl + 1;
+
+        std::string_view before(text_.data() + lineBegin, offset - lineBegin);
+        return { line, utf16_ ? utf16Length(before) : uint32_t(before.size()) };
+    }
+
+    Diagnostic diagnostic(size_t i, const LocalError& error) const {
+        const Statement& st = *statements_[i];
+        uint32_t end = i + 1 < statements_.size() ? statements_[i + 1]->start : text_.size();
+        uint32_t from = std::min(st.start + error.offset, end);
+
+        // no length -> rest of the line
+        uint32_t to = error.length > 0 ? from + error.length : nextLine(text_, from);
+        to = std::min(to, end);
+        if (to > from && text_[to - 1] == '\n') to--;
+
+        return { positionOf(i, from), positionOf(i, std::max(from, to)), error.message };
+    }
+};
+
+
+// ========== WRAPPER ==========
+Document::Document(SimplifiedCommandRegistry& reg, Options& options, std::string text, bool utf16)
+    : pImpl(std::make_unique<Impl>(reg, options, std::move(text), utf16)) {}
+
+Document::~Document() = default; // Needed for unique_ptr<Impl>
+
+void Document::edit(TextPos start, TextPos end, std::string_view text) {
+    pImpl->edit(start, end, text);
+}
+
+void Document::replace(std::string text) {
+    pImpl->replace(std::move(text));
+}
+
+std::vector<Diagnostic> Document::diagnostics() const {
+    return pImpl->diagnostics();
+}
+
+std::string_view Document::text() const {
+    return pImpl->text();
+}
+
+Document::Stats Document::stats() const {
+    return pImpl->stats();
+}
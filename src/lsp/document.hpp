@@ -0,0 +1,59 @@
+// lsp/document.hpp
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class SimplifiedCommandRegistry;
+struct Options;
+
+// position as the editor sends it -> 0-based line, character counted in utf-8 bytes or utf-16 code units
+struct TextPos {
+    uint32_t line;
+    uint32_t character;
+};
+
+struct Diagnostic {
+    TextPos start;
+    TextPos end;
+    std::string message;
+};
+
+// One open file of the language server (see ./server.hpp).
+// The text is kept as a list of top-level statements, each with its own AST and analysis results. An edit only
+// re-lexes & reparses the statements it touches (more if a brace or comment is left open), the statements after
+// it are moved, not parsed again. Analysis runs per statement with the variables it reads or writes taken from
+// the statements before it -> after an edit only statements using a variable whose value changed are analyzed again.
+// Every phase error becomes a diagnostic of its statement, a broken statement is skipped to the next line and
+// parsing goes on from there.
+class Document {
+public:
+    // utf16 -> positions are counted in utf-16 code units (LSP default), otherwise in bytes
+    Document(SimplifiedCommandRegistry& reg, Options& options, std::string text, bool utf16);
+    ~Document();
+
+    // replaces the text between start and end (TextDocumentContentChangeEvent with a range)
+    void edit(TextPos start, TextPos end, std::string_view text);
+
+    // whole new text (change without a range)
+    void replace(std::string text);
+
+    std::vector<Diagnostic> diagnostics() const;
+    std::string_view text() const;
+
+    // work done by the last edit, logged by the server
+    struct Stats {
+        size_t statements = 0;  // statements in the document
+        size_t reparsed = 0;    // bytes lexed & parsed again
+        size_t reanalyzed = 0;  // statements analyzed again
+    };
+    Stats stats() const;
+
+private:
+    // implementation
+    class Impl;
+    std::unique_ptr<Impl> pImpl;
+};
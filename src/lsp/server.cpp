@@ -0,0 +1,204 @@
+// lsp/server.cpp
+#include "./server.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+#include "./document.hpp"
+#include "./../core/options.hpp"
+#include "./../core/version.hpp"
+#include "./../../libs/json.hpp"
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+class LanguageServer::Impl {
+public:
+    Impl(Options& options, SimplifiedCommandRegistry& reg) : options_(options), reg_(reg) {}
+
+    int run() {
+        std::string body;
+        while (read(body)) {
+            json msg = json::parse(body, nullptr, false);
+            if (msg.is_discarded() || !msg.is_object()) {
+                send({ { "jsonrpc", "2.0" }, { "id", nullptr }, { "error", { { "code", -32700 }, { "message", "Parse error" } } } });
+                continue;
+            }
+
+            std::string method = msg.value("method", "");
+            if (method == "exit") return shutdown_ ? EXIT_SUCCESS : EXIT_FAILURE;
+
+            try {
+                handle(method, msg);
+            } catch (const json::exception& e) {
+                // missing or mistyped field -> the request fails, the server keeps going
+                if (msg.contains("id")) error(msg["id"], -32602, e.what());
+            } catch (const std::exception& e) {
+                // anything else is a bug in the server, still not worth losing the editor's session over
+                if (msg.contains("id")) error(msg["id"], -32603, std::string("Internal error: ") + e.what());
+                else fprintf(stderr, "lsp: %s failed: %s\n", method.c_str(), e.what());
+            }
+        }
+        return shutdown_ ? EXIT_SUCCESS : EXIT_FAILURE; // stdin closed without 'exit'
+    }
+
+private:
+    Options& options_;
+    SimplifiedCommandRegistry& reg_;
+
+    bool utf16_ = true;     // LSP default, utf-8 if the client supports it
+    bool shutdown_ = false;
+    std::unordered_map<std::string, std::unique_ptr<Document>> documents_; // uri -> document
+
+
+    void handle(const std::string& method, const json& msg) {
+        const json& params = msg.contains("params") ? msg["params"] : json::object();
+
+        if (method == "initialize") {
+            const json encodings = params.value("/capabilities/general/positionEncodings"_json_pointer, json::array());
+            for (const json& encoding : encodings) {
+                if (encoding == "utf-8") utf16_ = false;
+            }
+
+            reply(msg["id"], {
+                { "capabilities", {
+                    { "positionEncoding", utf16_ ? "utf-16" : "utf-8" },
+                    { "textDocumentSync", { { "openClose", true }, { "change", 2 } } }, // 2 -> incremental
+                } },
+                { "serverInfo", { { "name", "mcjava" }, { "version", COMPILER_VERSION } } },
+            });
+        } else if (method == "shutdown") {
+            shutdown_ = true;
+            reply(msg["id"], nullptr);
+        } else if (method == "textDocument/didOpen") {
+            const json& doc = params.at("textDocument");
+            std::string uri = doc.at("uri");
+
+            auto start = Clock::now();
+            auto& document = documents_[uri];
+            document = std::make_unique<Document>(reg_, options_, doc.at("text").get<std::string>(), utf16_);
+            publish(uri, *document);
+            log("opened", uri, *document, start);
+        } else if (method == "textDocument/didChange") {
+            std::string uri = params.at("textDocument").at("uri");
+            auto it = documents_.find(uri);
+            if (it == documents_.end()) return;
+
+            auto start = Clock::now();
+            Document& document = *it->second;
+            for (const json& change : params.at("contentChanges")) {
+                if (change.contains("range")) {
+                    const json& range = change["range"];
+                    document.edit(position(range.at("start")), position(range.at("end")), change.at("text").get<std::string>());
+                } else {
+                    document.replace(change.at("text"));
+                }
+            }
+            publish(uri, document);
+            log("changed", uri, document, start);
+        } else if (method == "textDocument/didClose") {
+            std::string uri = params.at("textDocument").at("uri");
+            documents_.erase(uri);
+            notify("textDocument/publishDiagnostics", { { "uri", uri }, { "diagnostics", json::array() } });
+        } else if (msg.contains("id")) {
+            error(msg["id"], -32601, "Method not found: " + method);
+        }
+        // other notifications (initialized, $/cancelRequest, ...) need nothing
+    }
+
+    static TextPos position(const json& pos) {
+        return { pos.at("line").get<uint32_t>(), pos.at("character").get<uint32_t>() };
+    }
+
+    void publish(const std::string& uri, const Document& document) {
+        json diagnostics = json::array();
+        for (const Diagnostic& d : document.diagnostics()) {
+            diagnostics.push_back({
+                { "range", {
+                    { "start", { { "line", d.start.line }, { "character", d.start.character } } },
+                    { "end",   { { "line", d.end.line },   { "character", d.end.character } } },
+                } },
+                { "severity", 1 }, // error
+                { "source", "mcjava" },
+                { "message", d.message },
+            });
+        }
+        notify("textDocument/publishDiagnostics", { { "uri", uri }, { "diagnostics", std::move(diagnostics) } });
+    }
+
+    void log(const char* what, const std::string& uri, const Document& document, Clock::time_point start) {
+        if (options_.silent) return;
+
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        Document::Stats stats = document.stats();
+        fprintf(stderr, "lsp: %s %s in %.2fms (%zu statements, %zu bytes reparsed, %zu reanalyzed)\n",
+            what, uri.c_str(), ms, stats.statements, stats.reparsed, stats.reanalyzed);
+    }
+
+
+    // ===== TRANSPORT =====
+
+    // one message, false at the end of stdin
+    // a header with a broken Content-Length is answered with a parse error, lines up to the next valid header are skipped
+    bool read(std::string& body) {
+        size_t length = 0;
+        bool hasLength = false;
+        bool broken = false;
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) {
+                if (hasLength) break;
+                if (broken) send({ { "jsonrpc", "2.0" }, { "id", nullptr }, { "error", { { "code", -32700 }, { "message", "Invalid Content-Length" } } } });
+                broken = false;
+                continue;
+            }
+            if (line.rfind("Content-Length:", 0) == 0) {
+                size_t at = line.find_first_not_of(' ', 15);
+                if (at == std::string::npos) at = line.size();
+                auto [end, ec] = std::from_chars(line.data() + at, line.data() + line.size(), length);
+                hasLength = ec == std::errc() && end == line.data() + line.size() && at < line.size();
+                broken = !hasLength;
+            }
+        }
+        if (!hasLength) return false;
+
+        body.resize(length);
+        return bool(std::cin.read(body.data(), length));
+    }
+
+    void send(const json& msg) {
+        // error messages may quote half of a multibyte character
+        std::string text = msg.dump(-1, ' ', false, json::error_handler_t::replace);
+        printf("Content-Length: %zu\r\n\r\n", text.size());
+        fwrite(text.data(), 1, text.size(), stdout);
+        fflush(stdout);
+    }
+
+    void reply(const json& id, json result) {
+        send({ { "jsonrpc", "2.0" }, { "id", id }, { "result", std::move(result) } });
+    }
+
+    void error(const json& id, int code, const std::string& message) {
+        send({ { "jsonrpc", "2.0" }, { "id", id }, { "error", { { "code", code }, { "message", message } } } });
+    }
+
+    void notify(const std::string& method, json params) {
+        send({ { "jsonrpc", "2.0" }, { "method", method }, { "params", std::move(params) } });
+    }
+};
+
+
+// ========== WRAPPER ==========
+LanguageServer::LanguageServer(Options& options, SimplifiedCommandRegistry& reg)
+    : pImpl(std::make_unique<Impl>(options, reg)) {}
+
+LanguageServer::~LanguageServer() = default; // Needed for unique_ptr<Impl>
+
+int LanguageServer::run() {
+    return pImpl->run();
+}
@@ -0,0 +1,26 @@
+// lsp/server.hpp
+#pragma once
+
+#include <memory>
+
+struct Options;
+class SimplifiedCommandRegistry;
+
+// Language server (-lsp): JSON-RPC over stdin / stdout as editors start it.
+// Open documents are kept in memory (see ./document.hpp) and synced incrementally, after every change
+// the diagnostics of the whole document are published. Positions are utf-8 if the client offers it, utf-16 otherwise.
+// Handles initialize, shutdown, exit and didOpen / didChange / didClose, other requests get MethodNotFound.
+// The time of every change is logged to stderr (unless -silent).
+class LanguageServer {
+public:
+    LanguageServer(Options& options, SimplifiedCommandRegistry& reg);
+    ~LanguageServer();
+
+    // serves until 'exit' or the end of stdin, returns the exit code
+    int run();
+
+private:
+    // implementation
+    class Impl;
+    std::unique_ptr<Impl> pImpl;
+};
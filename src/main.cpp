@@ -1,27 +1,39 @@
 #include <iostream>
+#include <charconv>
 #include <string>
 #include <vector>
 #include <sstream>
 #include <fstream>
 #include <unordered_map>
 #include <filesystem>
-#include <chrono>
 
 #include "./frontend/tokenizer.hpp"
 #include "./frontend/parser.hpp"
+#include "./middleend/resolver.hpp"
 #include "./middleend/analyzer.hpp"
 #include "./backend/debug_generator.hpp"
 #include "./backend/generator.hpp"
+#include "./driver/project.hpp"
+#include "./driver/cache.hpp"
+#include "./driver/daemon.hpp"
+#include "./lsp/server.hpp"
 
 #include "./registries/SimplifiedCommandRegistry.hpp"
 #include "./core/options.hpp"
 #include "./core/token.hpp"
+#include "./core/source.hpp"
+#include "./core/unit.hpp"
 #include "./core/ast.hpp"
+#include "./core/diagnostic.hpp"
+#include "./core/trace.hpp"
+#include "./core/stats.hpp"
 
 namespace fs = std::filesystem;
 
 void printHelp() {
-    std::cout << "Usage: mcjava <input.mcjava> [args]\n\n";
+    std::cout << "Usage: mcjava <input.mcjava> [args]\n";
+    std::cout << "       mcjava <source-dir> [args]      (project mode: every .mcjava file into one datapack)\n";
+    std::cout << "       mcjava -lsp [args]              (language server on stdin / stdout, see lsp/server.hpp)\n\n";
     std::cout << "Arguments:\n";
     std::cout << "  -dump-tokens                Dump tokens to a file\n";
     std::cout << "  -dump-cmds                  Dump all commands list to a file\n";
@@ -30,13 +42,22 @@ void printHelp() {
     std::cout << "  -analysis                   Only perform analysis, skip generation\n";
     std::cout << "  -disable-constant-folding   Disable constant folding optimization\n";
     std::cout << "  -keep-unused-vars           Keep unused variables in output\n";
+    std::cout << "  -incremental                Only regenerate functions whose code changed since the last build\n";
     std::cout << "  -silent                     Suppress all output except errors\n";
     std::cout << "  -mcdoc-path=<path>          Path to mcdoc commands.json (default: ./mcdoc/commands.json)\n";
     std::cout << "  -dp-prefix=<prefix>         Datapack function prefix (default: mcjava)\n";
     std::cout << "  -dp-path=<path>             Datapack function path (default: empty)\n";
+    std::cout << "  -cache-dir=<path>           Reuse functions generated earlier for unchanged scripts (default: no cache)\n";
+    std::cout << "  -cache-stats                Print compile cache hits & misses\n";
+    std::cout << "  -threads=<n>                Project mode: number of compiler threads (default: all cores)\n";
+    std::cout << "  -out=<path>                 Project mode: output directory (default: <source-dir>-out)\n";
+    std::cout << "  -daemon                     Stay up and recompile changed files, requests on stdin (see driver/daemon.hpp)\n";
+    std::cout << "  -trace=<file>               Write a Chrome trace of all phases and a .summary.json next to it (see core/trace.hpp)\n";
+    std::cout << "  -stats[=<file>]             Print what the optimizer did, with a file also as JSON (see core/stats.hpp)\n";
 }
 
-int main(int argc, char* argv[])
+// every phase throws CompileError instead of exiting -> it's printed here like the phases used to
+int main(int argc, char* argv[]) try
 {   
     // Check for help flag before other argument processing
     if (argc >= 2) {
@@ -92,6 +113,7 @@ int main(int argc, char* argv[])
     if (hasFlag("analysis"))                    options.onlyAnalysis        = true;
     if (hasFlag("disable-constant-folding"))    options.doConstantFolding   = false;
     if (hasFlag("keep-unused-vars"))            options.removeUnusedVars    = false;
+    if (hasFlag("incremental"))                 options.incremental         = true;
     
     // Other
     if (hasFlag("silent")) options.silent = true;
@@ -114,115 +136,260 @@ int main(int argc, char* argv[])
     }
 
 
+    // Compile cache
+    if (hasFlag("cache-dir")) options.cacheDir = args["cache-dir"];
+    if (hasFlag("cache-stats")) options.cacheStats = true;
+
+    // Project mode
+    if (hasFlag("threads")) {
+        const std::string& value = args["threads"];
+        auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), options.threads);
+        if (value.empty() || ec != std::errc() || end != value.data() + value.size()) {
+            std::cerr << "Incorrect usage: -threads=<n> expects a number (0 = all cores), got '" << value << "'" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (hasFlag("out")) options.outPath = args["out"];
+
+    // Daemon mode
+    if (hasFlag("daemon")) options.daemon = true;
+
+    // Instrumentation
+    if (hasFlag("trace")) options.tracePath = args["trace"];
+    if (hasFlag("stats")) {
+        options.stats = true;
+        if (args["stats"] != "true") options.statsPath = args["stats"];
+    }
+
+
+    // Language server -> started by the editor, stdout is the protocol
+    if (std::string(argv[1]) == "-lsp") {
+        SimplifiedCommandRegistry reg;
+        reg.loadAsync(options.mcdocPath);
+
+        std::string err;
+        if (!reg.wait(&err)) { std::cerr << "cmd load error: " << err << "\n"; return EXIT_FAILURE; }
+
+        LanguageServer server(options, reg);
+        return server.run();
+    }
+
+
+    // phases are measured by spans (core/trace.hpp), -trace also records them from here on
+    // the long running modes never finish a compile -> nothing would be written
+    if (!options.tracePath.empty() && !options.daemon) trace::enable();
+
     // First time measurement
     clock_t tStart = clock();
-    auto realStart = std::chrono::steady_clock::now();
+    trace::Span total("compile", argv[1]);
 
     std::string fullname = argv[1];
     std::string filename = fullname.substr(0, fullname.find_last_of("."));
 
-    std::string contents;
-    {
-        std::ifstream input(argv[1], std::ios::in);
-        std::string line;
-        while (std::getline(input, line)) {
-           contents += line;
-           contents += '\n'; // zawsze LF
+    std::unique_ptr<CompileCache> cache;
+    if (!options.cacheDir.empty()) cache = std::make_unique<CompileCache>(options.cacheDir);
+
+    auto printCacheStats = [&] {
+        if (cache && options.cacheStats) printf("Cache: %zu hits, %zu misses\n", cache->hits(), cache->misses());
+    };
+
+    // total times + the trace files, every successful exit goes through here
+    auto finish = [&] {
+        trace::Counters all = total.end();
+        if (!options.silent) {
+            printf("Time taken: %.4fs (CPU)\n", (double)(clock() - tStart)/CLOCKS_PER_SEC);
+            printf("Real time taken: %.4fs\n", all.wallNs / 1e9);
         }
+        printCacheStats();
+
+        std::string err;
+        if (trace::enabled() && !trace::write(options.tracePath, &err)) {
+            std::cerr << "trace error: " << err << "\n";
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    };
+    auto ms = [](const trace::Counters& phase) { return phase.wallNs / 1e6; };
+
+    // -stats -> text on stdout (unless it goes to a file and -silent), JSON into the file
+    auto report = [&](const OptimizationStats& stats) {
+        if (!options.stats) return true;
+        if (options.statsPath.empty() || !options.silent) std::cout << stats.text();
+        if (options.statsPath.empty()) return true;
+
+        std::ofstream file(options.statsPath, std::ios::out);
+        file << stats.json();
+        if (!file) std::cerr << "stats error: Could not write " << options.statsPath << "\n";
+        return bool(file);
+    };
+
+    if (options.daemon) {
+        SimplifiedCommandRegistry reg;
+        reg.loadAsync(options.mcdocPath);
+
+        std::string err;
+        if (!reg.wait(&err)) { std::cerr << "cmd load error: " << err << "\n"; return EXIT_FAILURE; }
+
+        Daemon daemon(options, reg, cache.get());
+        if (!daemon.watch(fullname)) return EXIT_FAILURE;
+        return daemon.run();
     }
 
-    // load simplified commands
-    SimplifiedCommandRegistry reg;
-    std::string err;
-    if (!reg.loadFromFile(options.mcdocPath, &err)) { std::cerr << "cmd load error: " << err << "\n"; return EXIT_FAILURE; }
+    if (fs::is_directory(fullname)) {
+        // trailing '/' would make the default output a subdirectory of the sources
+        fs::path root = fs::path(fullname).lexically_normal();
+        if (!root.has_filename()) root = root.parent_path();
+        fs::path out = options.outPath.empty() ? fs::path(root.string() + "-out") : fs::path(options.outPath);
 
-    if (options.dumpCmds) {
-        std::fstream file(filename + "-cmds.dump", std::ios::out);
-        for (std::string cmd : reg.getRoots()) {
-            file << cmd << std::endl;
-        }
+        SimplifiedCommandRegistry reg;
+        reg.loadAsync(options.mcdocPath);
+
+        Project project(root, out);
+        size_t failed = project.compile(options, reg, options.threads, cache.get());
+
+        if (!options.silent) printf("Compiled %zu files (%zu failed) into %s\n", project.files().size(), failed, out.string().c_str());
+        bool reported = report(project.stats());
+        int result = finish();
+        return failed == 0 && reported ? result : EXIT_FAILURE;
     }
 
-    // End of mcdoc parsing time measurement
-    clock_t tEndReg = clock();
+    // commands registry loads on a background thread while the source is read and lexed,
+    // the tokenizer waits for it at the first identifier
+    SimplifiedCommandRegistry reg;
+    reg.loadAsync(options.mcdocPath);
 
+    // source is mapped straight from the file, it has to outlive all phases -> tokens and AST only point into it
+    // AST nodes are allocated in the unit's arena and freed all at once with it
+    CompilationUnit unit;
+    Source& source = unit.source;
+    std::string err;
+    trace::Span reading("read source", fullname);
+    if (!source.loadFromFile(fullname, &err)) { std::cerr << "input error: " << err << "\n"; return EXIT_FAILURE; }
+    trace::Counters tRead = reading.end();
+
+    // unchanged script -> its functions are copied from the cache, nothing is lexed
+    // dumps & -analysis need the frontend anyway, they always compile
+    uint64_t cacheKey = 0;
+    bool useCache = cache && !options.onlyAnalysis && !options.stats && !options.dumpTokens && !options.dumpCmds && !options.dumpParseTree && !options.dumpAnalyzerTree;
+    if (useCache) {
+        if (!reg.wait(&err)) { std::cerr << "cmd load error: " << err << "\n"; return EXIT_FAILURE; }
+
+        trace::Span restoring("cache restore");
+        cacheKey = cache->key(source.text(), options, reg.sourceHash());
+        if (cache->restore(cacheKey, filename)) {
+            restoring.end();
+            if (!options.silent) std::cout << "Path: " << fs::path(filename) << " (from cache)\n";
+            return finish();
+        }
+    }
 
-    // Tokenization
-    Tokenizer tokenizer(std::move(contents), reg);
-    std::vector<Token> tokens = tokenizer.tokenize();
 
-    // end of tokenization time measurement
-    clock_t tEndTok = clock();
+    // Tokenization & Parsing
+    // by default tokens are streamed straight into the parser, the whole token vector is built only for -dump-tokens
+    // -> lexing is then measured as a part of parsing
+    Tokenizer tokenizer(source, reg);
+    trace::Counters tTok, tPar;
 
-    // if dump tokens argument is set, dump all tokens to a  separate file
     if (options.dumpTokens) {
-        std::fstream file(filename + "-token.dump", std::ios::out);
-        for (Token token : tokens) {
-            if (token.value.has_value()) {
-                file << tokenTypeToString(token.type) << " -> " << token.value.value() << std::endl;
-            } else {
-                file << tokenTypeToString(token.type) << std::endl;
+        trace::Span tokenizing("tokenize");
+        std::vector<Token> tokens = tokenizer.tokenize();
+        tTok = tokenizing.end();
+
+        // dump all tokens to a separate file
+        {
+            trace::Span dumping("dump", filename + "-token.dump");
+            std::fstream file(filename + "-token.dump", std::ios::out);
+            for (const Token& token : tokens) {
+                if (tokenHasValue(token.type)) {
+                    file << tokenTypeToString(token.type) << " -> " << source.lexeme(token) << std::endl;
+                } else {
+                    file << tokenTypeToString(token.type) << std::endl;
+                }
             }
         }
-    }
-
 
-    // Parsing tokens
-    Parser parser(std::move(tokens), reg);
-    auto ast = parser.parse(); // std::unique_ptr<ASTNode>
+        trace::Span parsing("parse");
+        Parser parser(std::move(tokens), source, reg, unit.arena);
+        unit.root = parser.parse();
+        tPar = parsing.end();
+    } else {
+        trace::Span parsing("parse", "streamed tokens");
+        Parser parser(tokenizer, source, reg, unit.arena);
+        unit.root = parser.parse();
+        tPar = parsing.end();
+    }
     
-    if (!ast) {
+    if (!unit.root) {
         std::cerr << "Parse failed: no AST generated" << std::endl;
         return EXIT_FAILURE;
     }
 
+    // program without any identifier never waited for the registry -> load errors are reported here
+    if (!reg.wait(&err)) { std::cerr << "cmd load error: " << err << "\n"; return EXIT_FAILURE; }
+
+    if (options.dumpCmds) {
+        trace::Span dumping("dump", filename + "-cmds.dump");
+        std::fstream file(filename + "-cmds.dump", std::ios::out);
+        for (std::string_view cmd : reg.getRoots()) {
+            file << cmd << std::endl;
+        }
+    }
+
     if (options.dumpParseTree) {
+        trace::Span dumping("dump", filename + "-parse-tree.dump");
         std::ofstream file(filename + "-parse-tree.dump", std::ios::out);
         if (file.is_open()) {
-            DebugGenerator debugGen(file);
-            debugGen.generate(*ast);
+            DebugGenerator debugGen(file, source, unit.vars);
+            debugGen.generate(*unit.root);
             file.close();
         }
     }
 
-    // end of parsing time measurement
-    clock_t tEndPar = clock();
+    // bind every variable use to its slot once
+    trace::Span resolving("resolve");
+    Resolver resolver;
+    resolver.resolve(*unit.root);
+    trace::Counters tRes = resolving.end();
 
-    Analyzer analyzer(options);
-    analyzer.analyze(*ast);
+    trace::Span analyzing("analyze");
+    Analyzer analyzer(options, source, unit.vars);
+    analyzer.analyze(*unit.root);
     const auto scopes = analyzer.getScopes();
+    trace::Counters tAnz = analyzing.end();
 
     if (options.dumpAnalyzerTree) {
+        trace::Span dumping("dump", filename + "-analyzer-tree.dump");
         std::ofstream file(filename + "-analyzer-tree.dump", std::ios::out);
         if (file.is_open()) {
-            DebugGenerator debugGen(file);
-            debugGen.generate(*ast);
+            DebugGenerator debugGen(file, source, unit.vars);
+            debugGen.generate(*unit.root);
             file.close();
         }
     }
 
-    clock_t tEndAnz = clock();
+    // Print and format gathered times (wall time of each phase)
+    auto printTimes = [&] {
+        if (options.silent) return;
+        printf("Time parsing mcdoc: %.2fms (%s, background)\n", reg.loadMs(), reg.fromSnapshot() ? "snapshot" : "commands.json");
+        printf("Time reading source: %.3fms\n", ms(tRead));
+        if (options.dumpTokens) printf("Time tokenizing: %.3fms\n", ms(tTok));
+        printf(options.dumpTokens ? "Time parsing: %.3fms\n" : "Time tokenizing & parsing: %.3fms\n", ms(tPar));
+        printf("Time resolving: %.3fms\n", ms(tRes));
+        printf("Time analyzing: %.3fms\n", ms(tAnz));
+    };
 
     // if -analysis then dont generate functions
     if (options.onlyAnalysis) {
-        auto realEnd = std::chrono::steady_clock::now();
-        
-        // Print and format gathered times
-        if (!options.silent) {
-            printf("Time parsing mcdoc: %.2fs\n", (double)(tEndReg - tStart)/CLOCKS_PER_SEC);
-            printf("Time tokenizing: %.2fs\n", (double)(tEndTok - tEndReg)/CLOCKS_PER_SEC);
-            printf("Time parsing: %.2fs\n", (double)(tEndPar - tEndTok)/CLOCKS_PER_SEC);
-            printf("Time analyzing: %.2fs\n", (double)(tEndAnz - tEndPar)/CLOCKS_PER_SEC);
-            printf("Time taken: %.4fs\n", (double)(clock() - tStart)/CLOCKS_PER_SEC);
-            printf("Real time taken: %.4fs\n", std::chrono::duration<double>(realEnd - realStart).count());
-        }
-
-        return EXIT_SUCCESS;
+        printTimes();
+        if (!report(analyzer.getStats())) return EXIT_FAILURE;
+        return finish();
     }
 
     
 
     // Generation
+    trace::Span generating("generate");
+    OptimizationStats stats = analyzer.getStats();
     {   
         try {
             fs::create_directory(filename);
@@ -232,24 +399,22 @@ int main(int argc, char* argv[])
 
         fs::path path(filename);
         if (!options.silent) std::cout << "Path: " << path << "\n";
-        FunctionGenerator funcGen(path, options, scopes);
-        funcGen.generate(*ast);
+        FunctionGenerator funcGen(path, options, scopes, source, unit.vars);
+        funcGen.generate(*unit.root);
+        stats.add(funcGen.stats());
+
+        if (useCache) {
+            trace::Span storing("cache store");
+            cache->store(cacheKey, funcGen.files());
+        }
     }
-    
-    // end of generation time measurement
-    clock_t tEndGen = clock();
-    auto realEnd = std::chrono::steady_clock::now();
-
-    // Print and format gathered times
-    if (!options.silent) {
-        printf("Time parsing mcdoc: %.2fs\n", (double)(tEndReg - tStart)/CLOCKS_PER_SEC);
-        printf("Time tokenizing: %.2fs\n", (double)(tEndTok - tEndReg)/CLOCKS_PER_SEC);
-        printf("Time parsing: %.2fs\n", (double)(tEndPar - tEndTok)/CLOCKS_PER_SEC);
-        printf("Time analyzing: %.2fs\n", (double)(tEndAnz - tEndPar)/CLOCKS_PER_SEC);
-        printf("Time generating: %.2fs\n", (double)(tEndGen - tEndAnz)/CLOCKS_PER_SEC);
-        printf("Time taken: %.4fs (CPU)\n", (double)(clock() - tStart)/CLOCKS_PER_SEC);
-        printf("Real time taken: %.4fs\n", std::chrono::duration<double>(realEnd - realStart).count());
-    }
-
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+    trace::Counters tGen = generating.end();
+
+    printTimes();
+    if (!options.silent) printf("Time generating: %.3fms\n", ms(tGen));
+    if (!report(stats)) return EXIT_FAILURE;
+    return finish();
+} catch (const CompileError& e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+}
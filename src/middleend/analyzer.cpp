@@ -2,48 +2,54 @@
 #include "./analyzer.hpp"
 
 #include <iostream>
+#include <charconv>
 
 #include "./../core/ast.hpp"
 #include "./../core/options.hpp"
+#include "./../core/source.hpp"
+#include "./../core/visitor.hpp"
+#include "./../core/diagnostic.hpp"
+#include "./../core/stats.hpp"
 
-class Analyzer::Impl : public ASTVisitor {
+class Analyzer::Impl : public ASTVisitor<Analyzer::Impl, VarInfo*> {
 public:
-    Impl(Options& options) : 
-        options_(options) {}
+    Impl(Options& options, const Source& source, VarPool& vars) : 
+        options_(options), source_(source), vars_(vars) {}
 
-    void analyze(ASTNode& node) {
-        node.accept(*this);
+    void analyze(ASTNode& node, const std::vector<VarId>& predeclared) {
+        predeclared_ = &predeclared;
+        visit(node);
     }
 
-    ASTReturn visitCommand(const CommandNode& node) override {
+    VarInfo* visitCommand(const CommandNode& node) {
         analyzeCommand(node);
         return nullptr;
     }
 
-    ASTReturn visitVarDecl(const VarDeclNode& node) override {
+    VarInfo* visitVarDecl(const VarDeclNode& node) {
         analyzeVarDecl(node);
         return nullptr;
     }
 
-    ASTReturn visitExpr(const ExprNode& node) override {
+    VarInfo* visitExpr(const ExprNode& node) {
         return analyzeExpr(node); 
     }
 
-    ASTReturn visitBinaryOp(const BinaryOpNode& node) override {
+    VarInfo* visitBinaryOp(const BinaryOpNode& node) {
         return analyzeBinaryOp(node);
     }
 
-    ASTReturn visitIf(const IfNode& node) override {
+    VarInfo* visitIf(const IfNode& node) {
         analyzeIf(node);
         return nullptr;
     }
 
-    ASTReturn visitWhile(const WhileNode& node) override {
+    VarInfo* visitWhile(const WhileNode& node) {
         analyzeWhile(node);
         return nullptr;
     }
 
-    ASTReturn visitScope(const ScopeNode& node) override {
+    VarInfo* visitScope(const ScopeNode& node) {
         analyzeScope(node);
         return nullptr;
     }
@@ -52,48 +58,95 @@ public:
         return allScopes_;
     }
 
+    const OptimizationStats& getStats() const {
+        return stats_;
+    }
+
 private:
     //std::unordered_map<std::string, std::shared_ptr<VarInfo>> variables_;
     std::vector<std::shared_ptr<Scope>> allScopes_;
     std::vector<std::shared_ptr<Scope>> scopeStack_;
-    size_t nextScopeId_ = 0;
 
     size_t tempVarCount_ = 0;
+    OptimizationStats stats_; // -stats
+    const std::vector<VarId>* predeclared_ = nullptr;
+    std::vector<size_t> outerTempCounts_; // -incremental: temps are numbered per scope, saved counters of the outer scopes
     const Options& options_;
+    const Source& source_;
+    VarPool& vars_;
+
+    // std::string scopeName = getCurrentScope().name;
+    const SymbolId scoreboard_ = intern("mcjava_sb_scope_0");
+    std::string nameBuf_; // reused when building generated names
 
     Scope& getCurrentScope() {
         if (scopeStack_.empty()) error("Tried to access empty scope stack");
         return *scopeStack_.back();
     }
 
-    std::string getCurrentScoreboard() const {
-        // std::string scopeName = getCurrentScope().name;
-        std::string scopeName = "scope_0";
-        return "mcjava_sb_" + scopeName;
+    SymbolId getCurrentScoreboard() const {
+        return scoreboard_;
+    }
+
+    SymbolId getTempVarName() {
+        stats_.tempsAllocated++;
+        char buf[24] = { '%' };
+        auto res = std::to_chars(buf + 1, buf + sizeof(buf), tempVarCount_++);
+        return intern(std::string_view(buf, res.ptr - buf));
+    }
+
+    // "%const_<value>"
+    SymbolId getConstName(std::string_view value) {
+        nameBuf_.assign("%const_");
+        nameBuf_.append(value);
+        return intern(nameBuf_);
     }
 
-    std::string getTempVarName() {
-        return "%" + std::to_string(tempVarCount_++);
+    SymbolId getConstName(int32_t value) {
+        char buf[16];
+        auto res = std::to_chars(buf, buf + sizeof(buf), value);
+        return getConstName(std::string_view(buf, res.ptr - buf));
     }
 
 
-    void enterScope() {
+    // scopes are numbered by the resolver, their id is also their index in allScopes_
+    void enterScope(const ScopeNode& node) {
         auto newScope = std::make_shared<Scope>();
 
-        newScope->id = nextScopeId_++;
+        newScope->id = node.scopeId;
         newScope->name = "scope_" + std::to_string(newScope->id);
-        newScope->parent = scopeStack_.empty() ? nullptr : scopeStack_.back();
+        newScope->slots.resize(node.slotCount, NO_VAR);
+
+        if (allScopes_.size() <= node.scopeId) allScopes_.resize(node.scopeId + 1);
+        allScopes_[node.scopeId] = newScope;
 
-        allScopes_.push_back(newScope);
+        // root scope -> predeclared names have the first slots (see Resolver::resolve)
+        if (scopeStack_.empty()) std::copy(predeclared_->begin(), predeclared_->end(), newScope->slots.begin());
         scopeStack_.push_back(newScope);
+
+        // an edit then only renames temps of its own scope, not of every function after it (see backend/generator.cpp)
+        // reusing %0.. in every scope is fine, a temp never outlives the statement that computed it
+        if (options_.incremental) {
+            outerTempCounts_.push_back(tempVarCount_);
+            tempVarCount_ = 0;
+        }
+    }
+
+    // current version of a resolved variable
+    VarId& slotOf(const Binding& binding) {
+        return allScopes_[binding.scope]->slots[binding.slot];
     }
 
     void exitScope() {
         if (scopeStack_.empty()) error("Tried to exit scope but scope stack is empty");
         scopeStack_.pop_back(); 
+
+        if (options_.incremental) {
+            tempVarCount_ = outerTempCounts_.back();
+            outerTempCounts_.pop_back();
+        }
     }
 
-    inline std::shared_ptr<VarInfo> visit(ASTNode& node) { return node.visit<std::shared_ptr<VarInfo>>(*this); }
 
 void analyzeCommand(const CommandNode& node) {
         for (const auto& arg : node.args) {
@@ -107,13 +160,13 @@ void analyzeCommand(const CommandNode& node) {
     void analyzeVarDecl(const VarDeclNode& node) {
         // analyze value first
         auto resultVar = visit(*node.value);
-        std::string varName = node.name.value.value();
+        SymbolId varName = node.symbol;
         
         if (varName.empty()) error("VarDecl Error: Variable name is empty!");
         if (!resultVar)      error("VarDecl Error: Should be UNREACHABLE");
 
         if (resultVar->dataType == DataType::UNKNOWN) {
-            error("VarDecl Error: Could not infer type of variable " + varName);
+            error("VarDecl Error: Could not infer type of variable " + std::string(varName.str()), node.name);
         }
         
         // redeclaration check -> we allow it
@@ -149,105 +202,108 @@ void analyzeCommand(const CommandNode& node) {
         };
         
         
-        auto varInfo = std::make_shared<VarInfo>(varData);
-        //variables_[varName] = varInfo;
-        // getCurrentScope().declare(varName, varInfo);
-
-        // FALSE if updated, TRUE if created new variable
-        bool isNew = getCurrentScope().declare(varName, varInfo);
+        VarId varId = vars_.add(varData);
+        // empty slot -> first assignment declares the variable, otherwise the new version replaces the old one
+        VarId& slot = slotOf(node.binding);
+        bool isNew = slot == NO_VAR;
+        slot = varId;
         if (!isNew) {
-            varInfo->isUsed = true;
+            vars_[varId].isUsed = true;
         }
 
-        node.varInfo = varInfo;
+        node.varId = varId;
         node.isAnalyzed = true;
     }
 
 
-    std::shared_ptr<VarInfo> analyzeExpr(const ExprNode& node) {
-        std::string tokValue = node.token.value.value();
+    VarInfo* analyzeExpr(const ExprNode& node) {
+        std::string_view tokValue = source_.lexeme(node.token);
 
         // if ident then handle  it specially before creating VarInfo struct (that varData below)
         if (node.token.type == TokenType::IDENT) {
             // if ident then tokValue = varName
 
             // check if variable exists
-            auto varInfo = getCurrentScope().lookup(tokValue);
-            if (!varInfo) {
-                error("Tried to use unassigned variable " + tokValue);
+            VarId varId = node.binding.resolved() ? slotOf(node.binding) : NO_VAR;
+            if (varId == NO_VAR) {
+                error("Tried to use unassigned variable " + std::string(tokValue), node.token);
                 return nullptr;
             }
 
+            VarInfo* varInfo = &vars_[varId];
             varInfo->isUsed = true;
 
             // use force dynamic only for variable use
             //if (node.forceDynamic) varInfo-> isConstant = true; // FIXME: for some reason if its flipped it generates right
         
-            node.varInfo = varInfo;
+            node.varId = varId;
             node.isAnalyzed = true;
             return varInfo;
         } 
 
-        // set all data to be sure everything is correct
-        VarInfo varData = {
-            .name          = "%const_" + tokValue, // its set but it should disappear in another steps of analyzing
-            .dataType      = DataType::UNKNOWN,
-
-            .isConstant    = false,
-            .constValue    = "",
-            
-            .storageType   = VarStorageType::SCOREBOARD, // for now we only support int so it will be fine with scoreboard
-            .storageIdent  = getCurrentScoreboard(),
-            .storagePath   = "%const_" + tokValue, // its set but it should disappear in another steps of analyzing
-
-            .isUsed        = false,
-            .isInitialized = true,
-        };
+        DataType dataType;
+        Constant constValue;
         
         switch (node.token.type)
         {
             case TokenType::INT_LIT :
-                varData.dataType   = DataType::INT;
-                varData.isConstant = true;
-                varData.constValue = tokValue;
+                dataType   = DataType::INT;
+                if (!Constant::parseInt(tokValue, constValue)) error("Integer literal out of range: " + std::string(tokValue), node.token);
                 break;
             
             case TokenType::FLOAT_LIT : 
-                varData.dataType   = DataType::FLOAT;
-                varData.isConstant = true;
-                varData.constValue = tokValue;
+                dataType   = DataType::FLOAT;
+                constValue = Constant::ofFloat(tokValue);
                 break;
             
             case TokenType::STRING_LIT :
-                varData.dataType   = DataType::STRING;
-                varData.isConstant = true;
-                varData.constValue = tokValue;
+                dataType   = DataType::STRING;
+                constValue = Constant::ofString(tokValue);
                 break;
             
             case TokenType::FALSE :
-                varData.dataType   = DataType::BOOL;
-                varData.isConstant = true;
-                varData.constValue = "0";
+                dataType   = DataType::BOOL;
+                constValue = Constant::ofBool(false);
                 break;
 
             case TokenType::TRUE :
-                varData.dataType   = DataType::BOOL;
-                varData.isConstant = true;
-                varData.constValue = "1";
+                dataType   = DataType::BOOL;
+                constValue = Constant::ofBool(true);
                 break;
             
             default:
             error("Got Expression node with unknown token type: " + tokenTypeToString(node.token.type));
         }
 
-        auto varInfo = std::make_shared<VarInfo>(varData);
+        // the same literal is stored only once
+        SymbolId constName = getConstName(tokValue);
+        VarId varId = vars_.findConstant(dataType, constName);
+
+        if (varId == NO_VAR) {
+            // set all data to be sure everything is correct
+            VarInfo varData = {
+                .name          = constName, // its set but it should disappear in another steps of analyzing
+                .dataType      = dataType,
+
+                .isConstant    = true,
+                .constValue    = constValue,
+                
+                .storageType   = VarStorageType::SCOREBOARD, // for now we only support int so it will be fine with scoreboard
+                .storageIdent  = getCurrentScoreboard(),
+                .storagePath   = constName, // its set but it should disappear in another steps of analyzing
+
+                .isUsed        = false,
+                .isInitialized = true,
+            };
+            varId = vars_.addConstant(varData);
+        }
         
-        node.varInfo = varInfo;
+        node.varId = varId;
         node.isAnalyzed = true;
-        return varInfo;
+        return &vars_[varId];
     }
 
-    std::shared_ptr<VarInfo> analyzeBinaryOp(const BinaryOpNode& node){
+    VarInfo* analyzeBinaryOp(const BinaryOpNode& node){
         // Implementation of binary operation analysis
         auto leftVar = visit(*node.left);
         auto rightVar = visit(*node.right);
@@ -261,21 +317,21 @@ void analyzeCommand(const CommandNode& node) {
 
 
         if (dataType == DataType::UNKNOWN) {
-            error("Not Matching types in binary operation: " + dataTypeToString(leftVar->dataType) + " and " + dataTypeToString(rightVar->dataType));
+            error("Not Matching types in binary operation: " + dataTypeToString(leftVar->dataType) + " and " + dataTypeToString(rightVar->dataType), node.op);
             return nullptr;
         }
 
         if (node.op.type == TokenType::DIVIDE) {
-            if (rightVar->isConstant && rightVar->constValue == "0") {
-                error("Division by zero detected in binary operation");
+            if (rightVar->isConstant && rightVar->constValue.isNumeric() && rightVar->constValue.value == 0) {
+                error("Division by zero detected in binary operation", node.op);
                 return nullptr;
             }
         }
 
         bool isConstant = leftVar->isConstant && rightVar->isConstant;
-        std::string constValue = "";
+        Constant constValue;
 
-        std::string storagePath;  // if its constant then it should disappear in another steps of analyzing
+        SymbolId storagePath;  // if its constant then it should disappear in another steps of analyzing
 
         if (options_.doConstantFolding && (leftVar->dataType != DataType::INT || rightVar->dataType != DataType::INT)) {
             // skip constant folding, because we dont support other datatypes than INT
@@ -285,25 +341,25 @@ void analyzeCommand(const CommandNode& node) {
         if (isConstant && options_.doConstantFolding) {
 
             // we only support integers for now
-            int leftValue  = std::stoi(leftVar ->constValue); 
-            int rightValue = std::stoi(rightVar->constValue);
+            int32_t leftValue  = leftVar ->constValue.value; 
+            int32_t rightValue = rightVar->constValue.value;
 
-            int outValue;
+            int32_t outValue;
             
             switch (node.op.type)
             {
             // Arithmetics
             case TokenType::PLUS :
-                outValue = leftValue + rightValue;
+                outValue = fold::add(leftValue, rightValue);
                 break;
             case TokenType::MINUS :
-                outValue = leftValue - rightValue;
+                outValue = fold::sub(leftValue, rightValue);
                 break;
             case TokenType::MULTIPLY :
-                outValue = leftValue * rightValue;
+                outValue = fold::mul(leftValue, rightValue);
                 break;
             case TokenType::DIVIDE :
-                outValue = leftValue / rightValue;
+                outValue = fold::div(leftValue, rightValue);
                 break;
 
             // comparison
@@ -331,15 +387,24 @@ void analyzeCommand(const CommandNode& node) {
                 error("SHOULD BE UNREACHABLE!");
             }
             
-            constValue = std::to_string(outValue);
-            storagePath = "%const_" + constValue; // this should dissapear in later stages of analyzing
+            constValue = dataType == DataType::BOOL ? Constant::ofBool(outValue) : Constant::ofInt(outValue);
+            storagePath = getConstName(outValue); // this should dissapear in later stages of analyzing
+            stats_.foldedNodes++;
         } else {
             isConstant = false;
-            constValue = "";
+            constValue = {};
             storagePath = getTempVarName();
         }
 
 
+        // folded values are deduplicated like literals
+        VarId varId = isConstant ? vars_.findConstant(dataType, storagePath) : NO_VAR;
+        if (varId != NO_VAR) {
+            node.varId = varId;
+            node.isAnalyzed = true;
+            return &vars_[varId];
+        }
+
         // set all data to be sure everything is correct
         VarInfo varData = { 
             .name           = storagePath, 
@@ -356,11 +421,11 @@ void analyzeCommand(const CommandNode& node) {
             .isInitialized  = true,
         };
 
-        auto varInfo = std::make_shared<VarInfo>(varData);
+        varId = isConstant ? vars_.addConstant(varData) : vars_.add(varData);
         
-        node.varInfo = varInfo;
+        node.varId = varId;
         node.isAnalyzed = true;
-        return varInfo;
+        return &vars_[varId];
     }
 
     void analyzeIf(const IfNode& node) {
@@ -368,36 +433,38 @@ void analyzeCommand(const CommandNode& node) {
         visit(*node.thenBranch);
         if (node.elseBranch) visit(*node.elseBranch);
 
-        if (varInfo->isConstant && !(varInfo->constValue == "0" || varInfo->constValue == "1")) {
-            error("If condition must have expression that returns true or false");
+        if (varInfo->isConstant && !varInfo->constValue.isBoolLike()) {
+            error("If condition must have expression that returns true or false", firstToken(node.condition));
         }
 
         node.isConditionConstant = varInfo->isConstant;
-        node.conditionValue      = (varInfo->constValue == "1"); // 1 -> true, 0 -> false
+        node.conditionValue      = varInfo->constValue.isBoolLike() && varInfo->constValue.value == 1; // 1 -> true, 0 -> false
+        if (node.isConditionConstant) stats_.staticConditions++;
 
         node.isAnalyzed = true;
     }
 
     void analyzeWhile(const WhileNode& node) {
-        invalidateVarsInNode(node.body.get());
+        invalidateVarsInNode(node.body);
         
         // we need to first invalidate variables that were changed in the loop body
         // and then we can analyze condition and body with correct information about which variables are constant
         auto varInfo = visit(*node.condition);
         visit(*node.body);
 
-        if (varInfo->isConstant && !(varInfo->constValue == "0" || varInfo->constValue == "1")) {
-            error("While condition must have expression that returns true or false");
+        if (varInfo->isConstant && !varInfo->constValue.isBoolLike()) {
+            error("While condition must have expression that returns true or false", firstToken(node.condition));
         } 
 
         node.isConditionConstant = varInfo->isConstant;
-        node.conditionValue      = varInfo->isConstant && (varInfo->constValue == "1");
+        node.conditionValue      = varInfo->isConstant && varInfo->constValue.isBoolLike() && varInfo->constValue.value == 1;
+        if (node.isConditionConstant) stats_.staticConditions++;
         
         node.isAnalyzed = true;
     }
 
     void analyzeScope(const ScopeNode& node) {
-        enterScope();
+        enterScope(node);
         for (const auto& arg : node.statements) {
             visit(*arg); // Analyze all nodes
         }
@@ -444,38 +511,46 @@ void analyzeCommand(const CommandNode& node) {
         if (!node) return;
 
         // If declaration (int y = ...), mark as non-constant
-        else if (auto decl = dynamic_cast<VarDeclNode*>(node)) {
+        else if (auto decl = node->as<VarDeclNode>()) {
             //std::cout << "Analyzer: Invalidate variable " << decl->name.value.value() << " as non-constant due to being in while loop body\n";
             //std::cout << "Analyzer: Variable " << decl->name.value.value() << " is now non-constant\n";
-            invalidateVarsInNode(decl->value.get());
+            invalidateVarsInNode(decl->value);
         }
-        else if (auto expr = dynamic_cast<ExprNode*>(node)) {
+        else if (auto expr = node->as<ExprNode>()) {
             // its double check is the TokenType is IDENT, another check is in analyzeExpr
             if (expr->token.type == TokenType::IDENT) {
                 expr->forceDynamic = true;
             }
         }
-        else if (auto bin = dynamic_cast<BinaryOpNode*>(node)) {
-            invalidateVarsInNode(bin->left.get());
-            invalidateVarsInNode(bin->right.get());
+        else if (auto bin = node->as<BinaryOpNode>()) {
+            invalidateVarsInNode(bin->left);
+            invalidateVarsInNode(bin->right);
         }
         // If it is scope, do recursive invalidation for all statements
-        else if (auto scope = dynamic_cast<ScopeNode*>(node)) {
-            for (auto& stmt : scope->statements) invalidateVarsInNode(stmt.get());
+        else if (auto scope = node->as<ScopeNode>()) {
+            for (auto& stmt : scope->statements) invalidateVarsInNode(stmt);
         }
     }
 
 private:
-    [[noreturn]] void error(const std::string& msg) {
-        std::cerr << "Analyzer error: " << msg << std::endl;
-        exit(EXIT_FAILURE);
+    // at -> where the error is for editors, the command line prints only the message
+    [[noreturn]] void error(const std::string& msg, const Token& at = Token{}) {
+        bool hasPos = at.type != TokenType::END_OF_FILE;
+        throw CompileError("Analyzer error: " + msg, msg, hasPos ? at.offset : CompileError::NO_OFFSET, at.length);
+    }
+
+    // leftmost token of an expression
+    static Token firstToken(const ASTNode* node) {
+        if (auto expr = node->as<ExprNode>()) return expr->token;
+        if (auto bin = node->as<BinaryOpNode>()) return firstToken(bin->left);
+        return Token{};
     }
 };
 
 
 // ========== WRAPPER ==========
-Analyzer::Analyzer(Options& options)
-    : pImpl(std::make_unique<Impl>(options)) {}
+Analyzer::Analyzer(Options& options, const Source& source, VarPool& vars)
+    : pImpl(std::make_unique<Impl>(options, source, vars)) {}
 
 Analyzer::~Analyzer() = default; // Needed for unique_ptr<Impl>
 
@@ -483,6 +558,14 @@ std::vector<std::shared_ptr<Scope>> Analyzer::getScopes() const {
     return pImpl->getScopes();
 }
 
+const OptimizationStats& Analyzer::getStats() const {
+    return pImpl->getStats();
+}
+
 void Analyzer::analyze(ASTNode& node) {
-    pImpl->analyze(node);
+    pImpl->analyze(node, {});
+}
+
+void Analyzer::analyze(ASTNode& node, const std::vector<VarId>& predeclared) {
+    pImpl->analyze(node, predeclared);
 }
\ No newline at end of file
@@ -1,22 +1,31 @@
 // middleend/analyzer.hpp
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
-#include "./../core/visitor.hpp"
 #include "./../core/scope.hpp"
 
 class Options;
 class ASTNode;
+class Source;
+class VarPool;
+struct OptimizationStats;
+using VarId = uint32_t;
 
 class Analyzer {
 public:
-    Analyzer(Options& options);
+    // every VarInfo created during analysis is stored in vars
+    Analyzer(Options& options, const Source& source, VarPool& vars);
     ~Analyzer();
 
     void analyze(ASTNode& node);
+    // predeclared -> values of the names the resolver predeclared (same order), they are put into the first slots of the root scope
+    void analyze(ASTNode& node, const std::vector<VarId>& predeclared);
     std::vector<std::shared_ptr<Scope>> getScopes() const;
+    // folded nodes, static conditions & temps of everything analyzed (-stats)
+    const OptimizationStats& getStats() const;
 private:
     // PImpl - implementation hidden in .cpp
     class Impl;
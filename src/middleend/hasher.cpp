@@ -0,0 +1,122 @@
+// middleend/hasher.cpp
+#include "./hasher.hpp"
+
+#include <unordered_map>
+
+#include "./../core/ast.hpp"
+#include "./../core/hash.hpp"
+#include "./../core/source.hpp"
+#include "./../core/visitor.hpp"
+
+class StructuralHasher::Impl : public ASTVisitor<StructuralHasher::Impl, uint64_t> {
+public:
+    Impl(const Source& source, const VarPool& vars, const std::vector<std::shared_ptr<Scope>>& scopes, uint64_t seed)
+        : source_(source), vars_(vars), scopes_(scopes), seed_(seed) {}
+
+    uint64_t hash(const ASTNode& node) {
+        auto it = memo_.find(&node);
+        if (it != memo_.end()) return it->second;
+
+        uint64_t h = visit(node);
+        memo_.emplace(&node, h);
+        return h;
+    }
+
+    uint64_t visitCommand(const CommandNode& node) {
+        uint64_t h = begin(node);
+        h = mix(h, source_.lexeme(node.command));
+        h = mix(h, source_.lexeme(node.text));
+        for (const ASTNode* arg : node.args) h = mix(h, hash(*arg));
+        return h;
+    }
+
+    uint64_t visitVarDecl(const VarDeclNode& node) {
+        uint64_t h = begin(node);
+        h = mixVar(h, node.varId);
+        return mix(h, node.value ? hash(*node.value) : 0);
+    }
+
+    uint64_t visitExpr(const ExprNode& node) {
+        uint64_t h = begin(node);
+        h = mix(h, static_cast<uint64_t>(node.token.type));
+        h = mix(h, source_.lexeme(node.token));
+        h = mix(h, node.forceDynamic);
+        h = mixVar(h, node.varId);
+
+        // a dynamic identifier is read from the current version of its variable (same lookup as the generator)
+        if (node.binding.resolved()) h = mixVar(h, scopes_[node.binding.scope]->slots[node.binding.slot]);
+        return h;
+    }
+
+    uint64_t visitBinaryOp(const BinaryOpNode& node) {
+        uint64_t h = begin(node);
+        h = mix(h, source_.lexeme(node.op));
+        h = mixVar(h, node.varId);
+        h = mix(h, hash(*node.left));
+        return mix(h, hash(*node.right));
+    }
+
+    uint64_t visitIf(const IfNode& node) {
+        uint64_t h = begin(node);
+        h = mix(h, node.isConditionConstant * 2 + node.conditionValue);
+        h = mix(h, hash(*node.condition));
+        h = mix(h, hash(*node.thenBranch));
+        return mix(h, node.elseBranch ? hash(*node.elseBranch) : 0);
+    }
+
+    uint64_t visitWhile(const WhileNode& node) {
+        uint64_t h = begin(node);
+        h = mix(h, node.isConditionConstant * 2 + node.conditionValue);
+        h = mix(h, hash(*node.condition));
+        return mix(h, hash(*node.body));
+    }
+
+    uint64_t visitScope(const ScopeNode& node) {
+        uint64_t h = begin(node);
+        for (const ASTNode* stmt : node.statements) h = mix(h, hash(*stmt));
+        return h;
+    }
+
+private:
+    const Source& source_;
+    const VarPool& vars_;
+    const std::vector<std::shared_ptr<Scope>>& scopes_;
+    const uint64_t seed_;
+
+    std::unordered_map<const ASTNode*, uint64_t> memo_;
+
+    static uint64_t mix(uint64_t h, uint64_t value) { return hashBytes(&value, sizeof(value), h); }
+    static uint64_t mix(uint64_t h, std::string_view text) { return hashBytes(text, h); }
+
+    // kind & annotations -> every node starts with them
+    uint64_t begin(const ASTNode& node) const {
+        uint64_t h = mix(seed_, static_cast<uint64_t>(node.kind));
+        for (const Annotation& anno : node.annotations) h = mix(h, anno.name);
+        return h;
+    }
+
+    uint64_t mixVar(uint64_t h, VarId id) const {
+        if (id == NO_VAR) return mix(h, uint64_t(NO_VAR));
+
+        const VarInfo& var = vars_[id];
+        h = mix(h, var.name.str());
+        h = mix(h, static_cast<uint64_t>(var.dataType));
+        h = mix(h, (uint64_t(var.isConstant) << 2) | (uint64_t(var.isUsed) << 1) | uint64_t(var.isInitialized));
+        h = mix(h, (uint64_t(var.constValue.kind) << 32) | uint32_t(var.constValue.value));
+        h = mix(h, var.constValue.text);
+        h = mix(h, static_cast<uint64_t>(var.storageType));
+        h = mix(h, var.storageIdent.str());
+        return mix(h, var.storagePath.str());
+    }
+};
+
+
+// ========== WRAPPER ==========
+StructuralHasher::StructuralHasher(const Source& source, const VarPool& vars, const std::vector<std::shared_ptr<Scope>>& scopes, uint64_t seed)
+    : pImpl(std::make_unique<Impl>(source, vars, scopes, seed)) {}
+
+StructuralHasher::~StructuralHasher() = default; // Needed for unique_ptr<Impl>
+
+uint64_t StructuralHasher::hash(const ASTNode& node) {
+    return pImpl->hash(node);
+}
@@ -0,0 +1,31 @@
+// middleend/hasher.hpp
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "./../core/scope.hpp"
+
+class ASTNode;
+class Source;
+class VarPool;
+
+// Structural hash of analyzed subtrees, used by -incremental to name functions (see backend/generator.cpp).
+// A node's hash covers everything the generator reads for it: kinds, lexemes, annotations, the analyzed
+// VarInfo of every value (constant, storage names, used flag) and the hashes of its children (Merkle style),
+// so two subtrees with the same hash generate the same commands. Symbols are hashed by text, never by id
+// -> the hash of a subtree doesn't move when something is interned earlier.
+// Runs after the analyzer, every node is hashed at most once.
+class StructuralHasher {
+public:
+    // seed covers whatever is the same for the whole unit (options, compiler version)
+    StructuralHasher(const Source& source, const VarPool& vars, const std::vector<std::shared_ptr<Scope>>& scopes, uint64_t seed);
+    ~StructuralHasher();
+
+    uint64_t hash(const ASTNode& node);
+private:
+    // implementation
+    class Impl;
+    std::unique_ptr<Impl> pImpl;
+};
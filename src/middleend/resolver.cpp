@@ -0,0 +1,102 @@
+// middleend/resolver.cpp
+#include "./resolver.hpp"
+
+#include <vector>
+
+#include "./../core/ast.hpp"
+#include "./../core/visitor.hpp"
+
+class Resolver::Impl : public ASTVisitor<Resolver::Impl> {
+public:
+    void resolve(ASTNode& root, const std::vector<SymbolId>& predeclared) {
+        predeclared_ = &predeclared;
+        nextScopeId_ = 0; // the language server reuses one resolver for every statement
+        visit(root);
+    }
+
+    void visitCommand(const CommandNode& node) {
+        for (const auto& arg : node.args) visit(*arg);
+    }
+
+    void visitVarDecl(const VarDeclNode& node) {
+        // value first -> "x = x + 1" reads the previous x
+        visit(*node.value);
+
+        // assigning to a visible variable updates it, otherwise the variable is declared in the current scope
+        Binding& binding = visibleSlot(node.symbol);
+        if (!binding.resolved()) {
+            const ScopeNode& scope = *scopeStack_.back();
+            binding = { .scope = scope.scopeId, .slot = scope.slotCount++ };
+            declared_.push_back(node.symbol);
+        }
+        node.binding = binding;
+    }
+
+    void visitExpr(const ExprNode& node) {
+        if (node.token.type == TokenType::IDENT) node.binding = visibleSlot(node.symbol);
+    }
+
+    void visitBinaryOp(const BinaryOpNode& node) {
+        visit(*node.left);
+        visit(*node.right);
+    }
+
+    // same order as the analyzer -> condition, then, else
+    void visitIf(const IfNode& node) {
+        visit(*node.condition);
+        visit(*node.thenBranch);
+        if (node.elseBranch) visit(*node.elseBranch);
+    }
+
+    void visitWhile(const WhileNode& node) {
+        visit(*node.condition);
+        visit(*node.body);
+    }
+
+    void visitScope(const ScopeNode& node) {
+        node.scopeId   = nextScopeId_++;
+        node.slotCount = 0;
+
+        scopeStack_.push_back(&node);
+        size_t mark = declared_.size();
+
+        if (scopeStack_.size() == 1) {
+            for (SymbolId name : *predeclared_) {
+                visibleSlot(name) = { .scope = node.scopeId, .slot = node.slotCount++ };
+                declared_.push_back(name);
+            }
+        }
+
+        for (const auto& stmt : node.statements) visit(*stmt);
+
+        // names declared in this scope stop being visible
+        for (size_t i = mark; i < declared_.size(); i++) visible_[declared_[i].id] = {};
+        declared_.resize(mark);
+        scopeStack_.pop_back();
+    }
+
+private:
+    std::vector<const ScopeNode*> scopeStack_;
+    uint32_t nextScopeId_ = 0;
+    const std::vector<SymbolId>* predeclared_ = nullptr;
+
+    // a name can't be shadowed (assignment updates the visible variable), so at most one binding per name
+    // is visible at a time -> flat table indexed by SymbolId, no hashing and no walk up the scopes
+    std::vector<Binding> visible_;
+    std::vector<SymbolId> declared_; // names in declaration order, popped when their scope ends
+
+    Binding& visibleSlot(SymbolId name) {
+        if (name.id >= visible_.size()) visible_.resize(name.id + 1);
+        return visible_[name.id];
+    }
+};
+
+// ========== WRAPPER ==========
+Resolver::Resolver()
+    : pImpl(std::make_unique<Impl>()) {}
+
+Resolver::~Resolver() = default; // Needed for unique_ptr<Impl>
+
+void Resolver::resolve(ASTNode& root, const std::vector<SymbolId>& predeclared) {
+    pImpl->resolve(root, predeclared);
+}
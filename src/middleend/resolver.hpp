@@ -0,0 +1,27 @@
+// middleend/resolver.hpp
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "./../core/interner.hpp"
+
+class ASTNode;
+
+// Name resolution, runs once between parsing and analysis.
+// Numbers the scopes in preorder and binds every variable declaration and identifier use to a
+// (declaring scope, slot) pair, so the analyzer and generator index slot arrays instead of hashing names.
+// Unresolved identifiers are left unbound -> analyzer reports them in program order like any other error.
+class Resolver {
+public:
+    Resolver();
+    ~Resolver();
+
+    // predeclared -> names that already exist before root (language server, one statement at a time),
+    // they take the first slots of the root scope in the given order
+    void resolve(ASTNode& root, const std::vector<SymbolId>& predeclared = {});
+private:
+    // implementation
+    class Impl;
+    std::unique_ptr<Impl> pImpl;
+};
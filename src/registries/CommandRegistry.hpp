@@ -7,6 +7,7 @@
 #include <fstream>
 #include <iostream>
 #include <optional>
+#include <cstdint>
 
 #include "../../libs/json.hpp"
 using json = nlohmann::json;
@@ -19,6 +20,8 @@ struct SyntaxToken {
     std::optional<std::string> parser;    // e.g. "minecraft:entity" or "brigadier:integer"
     std::optional<json> properties;       // raw properties object if present
     bool executable_here = false;         // marks if node with this token is executable
+    // last token of a variant that continues with the variants of another node (key = its path, "" = any command)
+    bool is_redirect = false;
 };
 
 // A variant (one possible full syntax) is a sequence of SyntaxToken
@@ -33,6 +36,11 @@ struct CmdNode {
     std::optional<json> properties;    // optional properties object
     std::unordered_map<std::string, std::unique_ptr<CmdNode>> children;
     std::vector<std::string> redirect; // if present
+
+    // filled once after loading
+    std::vector<const CmdNode*> ordered;     // children in a fixed order (json objects are sorted) -> variants always come out the same
+    const CmdNode* redirectNode = nullptr;   // resolved redirect, "execute run" (no children, no redirect) -> root
+    uint64_t variantCount = 0;               // memoized number of variants from this node (redirects count as one)
 };
 
 class CommandRegistry {
@@ -50,13 +58,8 @@ public:
             json j; f >> j;
             // root may be object with "type":"root" and "children"
             if (j.is_object() && j.contains("children")) {
-                auto &children = j["children"];
-                for (auto it = children.begin(); it != children.end(); ++it) {
-                    // top-level keys are command names: literal nodes
-                    std::string cmdName = it.key();
-                    auto node = parseNodeRecursive(it.key(), it.value());
-                    roots.emplace(cmdName, std::move(node));
-                }
+                root_ = parseNodeRecursive("", j);
+                link(root_.get());
                 return true;
             } else {
                 if (err) *err = "Unexpected JSON format: missing top-level children";
@@ -71,56 +74,172 @@ public:
     // Return list of top-level command names
     std::vector<std::string> rootCommands() const {
         std::vector<std::string> out;
-        out.reserve(roots.size());
-        for (auto &p : roots) out.push_back(p.first);
+        if (!root_) return out;
+        out.reserve(root_->ordered.size());
+        for (const CmdNode* cmd : root_->ordered) out.push_back(cmd->key);
         return out;
     }
 
     const CmdNode* getRootNodeFor(const std::string& cmdName) const {
-        auto it = roots.find(cmdName);
-        if (it == roots.end()) return nullptr;
-        
+        if (!root_) return nullptr;
+        auto it = root_->children.find(cmdName);
+        if (it == root_->children.end()) return nullptr;
+
         return it->second.get();
     }
 
+    // the node every command hangs from, redirect target of "execute run"
+    const CmdNode* root() const { return root_.get(); }
+
+    // Lazy walk over the variants of one command. Nothing is copied per variant, path() is only valid until the
+    // next call to next(). A redirect ends the variant (redirect() says where it continues) unless followRedirects
+    // allows to expand it in place. A redirect to a node that is already being expanded on the current path is
+    // never followed (execute as <targets> -> execute), so every walk is finite.
+    //
+    //   for (auto v = reg.variants("execute"); v.next(); ) use(v.path(), v.redirect());
+    class VariantCursor {
+    public:
+        // advances to the next variant, false when there are no more
+        bool next() {
+            while (!stack_.empty()) {
+                Frame& f = stack_.back();
+                const CmdNode* node = f.node;
+
+                if (f.step == 0) {
+                    f.step = 1;
+                    // a redirected node isn't part of the path, only its children are
+                    if (!f.viaRedirect && node->executable) { redirect_ = nullptr; return true; }
+                }
+                if (f.step == 1) {
+                    f.step = 2;
+                    const CmdNode* target = node->redirectNode;
+                    if (target && !f.viaRedirect) {
+                        if (redirectsLeft_ != 0 && !onStack(target)) {
+                            if (redirectsLeft_ > 0) redirectsLeft_--;
+                            stack_.push_back({ target, 0, 0, true });
+                            continue;
+                        }
+                        redirect_ = target;
+                        return true;
+                    }
+                }
+                if (f.child < node->ordered.size()) {
+                    const CmdNode* child = node->ordered[f.child++];
+                    path_.push_back(child);
+                    stack_.push_back({ child, 0, 0, false });
+                    continue;
+                }
+
+                // done with this node
+                bool viaRedirect = f.viaRedirect;
+                stack_.pop_back();
+                if (viaRedirect) {
+                    if (redirectsLeft_ >= 0) redirectsLeft_++;
+                } else if (!path_.empty()) {
+                    path_.pop_back();
+                }
+            }
+            return false;
+        }
+
+        // nodes from the command itself to the last token of the variant
+        const std::vector<const CmdNode*>& path() const { return path_; }
+
+        // where the variant continues (nullptr if it ends at an executable node)
+        const CmdNode* redirect() const { return redirect_; }
+
+    private:
+        friend class CommandRegistry;
+
+        struct Frame {
+            const CmdNode* node;
+            size_t child;       // next child in node->ordered
+            uint8_t step;       // 0 = node itself, 1 = its redirect, 2 = children
+            bool viaRedirect;   // entered through a redirect -> not on path_
+        };
+
+        std::vector<Frame> stack_;
+        std::vector<const CmdNode*> path_;
+        const CmdNode* redirect_ = nullptr;
+        int redirectsLeft_ = 0;    // < 0 -> no limit (cycles are still cut)
+
+        VariantCursor(const CmdNode* cmd, int followRedirects) : redirectsLeft_(followRedirects) {
+            if (!cmd) return;
+            path_.push_back(cmd);
+            stack_.push_back({ cmd, 0, 0, false });
+        }
+
+        bool onStack(const CmdNode* node) const {
+            for (const Frame& f : stack_) if (f.node == node) return true;
+            return false;
+        }
+    };
+
+    // followRedirects = how many redirects may be expanded in place on one path (-1 = as many as there are without cycles)
+    VariantCursor variants(const std::string& cmdName, int followRedirects = 0) const {
+        return VariantCursor(getRootNodeFor(cmdName), followRedirects);
+    }
+
+    // number of variants(cmdName) yields without following redirects, O(1)
+    uint64_t variantCount(const std::string& cmdName) const {
+        const CmdNode* node = getRootNodeFor(cmdName);
+        return node ? node->variantCount : 0;
+    }
+
+    // target of a node's redirect as written in the json ("" = any command, e.g. "execute run")
+    static std::string redirectPath(const CmdNode* node) {
+        std::string out;
+        for (const auto& key : node->redirect) {
+            if (!out.empty()) out += ' ';
+            out += key;
+        }
+        return out;
+    }
+
     // Get all syntax variants for command e.g. "teleport"
-    // Each variant is a sequence of tokens (literal/argument) that ends at an executable node
+    // Each variant is a sequence of tokens (literal/argument) that ends at an executable node or at a redirect
     std::vector<SyntaxVariant> getSyntaxVariants(const std::string& cmdName) const {
         std::vector<SyntaxVariant> out;
-        auto it = roots.find(cmdName);
-        if (it == roots.end()) return out;
-        SyntaxVariant cur;
-        SyntaxToken topTok;
-        topTok.is_literal = true;
-        topTok.key = cmdName;
-        topTok.executable_here = it->second->executable;
-        cur.push_back(topTok);
-
-        collectVariants(it->second.get(), cur, out, this); // <-- przekaż wskaźnik registry
+        out.reserve(variantCount(cmdName));
+        for (auto v = variants(cmdName); v.next(); ) {
+            SyntaxVariant cur;
+            cur.reserve(v.path().size() + 1);
+            for (const CmdNode* node : v.path()) cur.push_back(toToken(node));
+
+            if (v.redirect()) {
+                SyntaxToken tok;
+                tok.is_redirect = true;
+                tok.key = redirectPath(v.path().back());
+                cur.push_back(tok);
+            }
+            out.push_back(std::move(cur));
+        }
         return out;
     }
 
     // Debug helper: print variants
     void printVariants(const std::string& cmdName, std::ostream& os = std::cout) const {
-        auto vars = getSyntaxVariants(cmdName);
-        if (vars.empty()) {
-            os << "No variants for " << cmdName << "\n";
-            return;
-        }
         size_t idx = 0;
-        for (auto &v : vars) {
+        for (auto v = variants(cmdName); v.next(); ) {
             os << idx++ << ": ";
-            for (size_t i=0;i<v.size();++i) {
+            for (size_t i = 0; i < v.path().size(); ++i) {
+                const CmdNode* node = v.path()[i];
                 if (i) os << " ";
-                if (v[i].is_literal) os << v[i].key;
+                if (node->type == "literal") os << node->key;
                 else {
-                    os << "<" << v[i].key;
-                    if (v[i].parser) os << ":" << *v[i].parser;
+                    os << "<" << node->key;
+                    if (node->parser) os << ":" << *node->parser;
                     os << ">";
                 }
             }
-            os << (v.back().executable_here ? " [executable]" : "") << "\n";
+            if (v.redirect()) {
+                std::string target = redirectPath(v.path().back());
+                os << " -> " << (target.empty() ? "<command>" : target) << "\n";
+            } else {
+                os << " [executable]\n";
+            }
         }
+        if (idx == 0) os << "No variants for " << cmdName << "\n";
     }
 
     // Find a node by walking exact tokens (literals or accepting argument nodes)
@@ -128,26 +247,26 @@ public:
     // tokens: sequence of source tokens (strings).
     // Returns pair(found, executable_at_node)
     std::pair<bool,bool> matchTokens(const std::string& cmdName, const std::vector<std::string>& tokens) const {
-        auto it = roots.find(cmdName);
-        if (it == roots.end()) return {false,false};
-        const CmdNode* node = it->second.get();
+        const CmdNode* node = getRootNodeFor(cmdName);
+        if (!node) return {false,false};
         size_t idx = 0;
         // first token corresponds to top-level command and is already matched
         if (idx < tokens.size() && tokens[0] == cmdName) ++idx;
         // walk remaining tokens
         while (idx < tokens.size()) {
             const std::string &tok = tokens[idx];
+            // after a redirect the children come from the target
+            const CmdNode* from = node->redirectNode ? node->redirectNode : node;
             // prefer exact literal child match
-            auto litIt = node->children.find(tok);
-            if (litIt != node->children.end()) {
+            auto litIt = from->children.find(tok);
+            if (litIt != from->children.end() && litIt->second->type == "literal") {
                 node = litIt->second.get();
                 ++idx;
                 continue;
             }
             // else try to match any argument child (type == "argument")
             bool consumed = false;
-            for (auto &chp : node->children) {
-                const CmdNode* child = chp.second.get();
+            for (const CmdNode* child : from->ordered) {
                 if (child->type == "argument") {
                     // we accept token as argument (we don't fully validate parser here)
                     node = child;
@@ -162,7 +281,7 @@ public:
     }
 
 private:
-    std::unordered_map<std::string, std::unique_ptr<CmdNode>> roots;
+    std::unique_ptr<CmdNode> root_;
 
     // parse one JSON node into CmdNode recursively
     static std::unique_ptr<CmdNode> parseNodeRecursive(const std::string& key, const json& jnode) {
@@ -177,46 +296,45 @@ private:
         }
         if (jnode.contains("children") && jnode["children"].is_object()) {
             for (auto it = jnode["children"].begin(); it != jnode["children"].end(); ++it) {
-                n->children.emplace(it.key(), parseNodeRecursive(it.key(), it.value()));
+                auto child = parseNodeRecursive(it.key(), it.value());
+                n->ordered.push_back(child.get());
+                n->children.emplace(it.key(), std::move(child));
             }
         }
         return n;
     }
 
-    // DFS collecting variants; cur already contains the sequence to the current node (including it)
-    static void collectVariants(const CmdNode* node, SyntaxVariant& cur, std::vector<SyntaxVariant>& out, const CommandRegistry* reg = nullptr) {
-    if (!cur.empty()) cur.back().executable_here = node->executable;
-    if (node->executable) out.push_back(cur);
-
-    // najpierw obsłuż dzieci normalne
-    for (const auto &p : node->children) {
-        const auto *child = p.second.get();
-        SyntaxToken tok;
-        tok.is_literal = (child->type == "literal");
-        tok.key = child->key;
-        tok.executable_here = child->executable;
-        if (!tok.is_literal) {
-            if (child->parser) tok.parser = child->parser;
-            if (child->properties) tok.properties = *(child->properties);
+    // resolves redirects and counts variants bottom-up (children are counted before their parent)
+    void link(CmdNode* node) {
+        if (!node->redirect.empty()) {
+            const CmdNode* target = root_.get();
+            for (const auto& key : node->redirect) {
+                auto it = target->children.find(key);
+                if (it == target->children.end()) { target = nullptr; break; }
+                target = it->second.get();
+            }
+            node->redirectNode = target;
+        } else if (node != root_.get() && node->children.empty() && !node->executable) {
+            node->redirectNode = root_.get();
         }
-        cur.push_back(tok);
 
-        // rekurencyjne wywołanie
-        collectVariants(child, cur, out, reg);
-        cur.pop_back();
+        uint64_t count = (node->executable ? 1 : 0) + (node->redirectNode ? 1 : 0);
+        for (const CmdNode* child : node->ordered) {
+            link(const_cast<CmdNode*>(child));
+            count += child->variantCount;
+        }
+        node->variantCount = count;
     }
 
-    // teraz obsłuż redirect
-    if (!node->redirect.empty() && reg) {
-        for (const auto &rname : node->redirect) {
-            auto redirectedVariants = reg->getSyntaxVariants(rname);
-            for (auto &rv : redirectedVariants) {
-                SyntaxVariant combined = cur; // aktualny wariant
-                // pomijamy pierwszy token (nazwę komendy redirect) aby nie dublować
-                for (size_t i = 1; i < rv.size(); ++i) combined.push_back(rv[i]);
-                out.push_back(combined);
-            }
+    static SyntaxToken toToken(const CmdNode* node) {
+        SyntaxToken tok;
+        tok.is_literal = (node->type == "literal");
+        tok.key = node->key;
+        tok.executable_here = node->executable;
+        if (!tok.is_literal) {
+            if (node->parser) tok.parser = node->parser;
+            if (node->properties) tok.properties = *(node->properties);
         }
+        return tok;
     }
-}
 };
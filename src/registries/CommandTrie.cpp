@@ -0,0 +1,430 @@
+// CommandTrie.cpp
+#include "./CommandTrie.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <limits>
+#include <unordered_map>
+
+#include "./JsonScanner.hpp"
+
+// ===== BUILD =====
+namespace {
+
+    // tree as it is in the json, only used while building
+    struct BuildNode {
+        std::string name;
+        bool isArgument = false;
+        bool executable = false;
+        std::string parser;
+        std::string stringType;             // brigadier:string properties.type
+        bool hasBounds = false;
+        TrieBounds bounds = { -std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity() };
+        std::vector<std::string> redirect;  // path from the root
+        int64_t level = -1;                 // required_level (only top-level commands have it)
+        std::vector<uint32_t> children;
+    };
+
+    class TrieBuilder {
+    public:
+        explicit TrieBuilder(std::string_view json) : in_(json) {}
+
+        bool parse(std::string* err) {
+            nodes_.clear();
+            nodes_.emplace_back(); // root
+            if (!parseNode(0, 0)) {
+                if (err) *err = "JSON parse error: invalid command tree at offset " + std::to_string(in_.offset());
+                return false;
+            }
+            return true;
+        }
+
+        void layout(int maxLevel, CommandTrie::Data& out) {
+            out.nodes.clear();
+            out.bounds.clear();
+            out.strings.clear();
+            strings_.clear();
+
+            std::vector<uint32_t> finalOf(nodes_.size(), TrieNode::NONE);
+            std::vector<uint32_t> queue = { 0 };
+            finalOf[0] = 0;
+            out.nodes.push_back(TrieNode{});
+
+            // breadth first -> children of every node end up next to each other
+            for (size_t qi = 0; qi < queue.size(); qi++) {
+                uint32_t b = queue[qi];
+
+                std::vector<uint32_t> kids;
+                for (uint32_t kid : nodes_[b].children) {
+                    // commands the datapack can't run are not reachable at all
+                    if (b == 0 && (nodes_[kid].level < 0 || nodes_[kid].level > maxLevel)) continue;
+                    kids.push_back(kid);
+                }
+                // literals sorted by name, arguments keep the json order (it is the order brigadier tries them in)
+                std::stable_partition(kids.begin(), kids.end(), [&](uint32_t k) { return !nodes_[k].isArgument; });
+                auto firstArg = std::find_if(kids.begin(), kids.end(), [&](uint32_t k) { return nodes_[k].isArgument; });
+                std::sort(kids.begin(), firstArg, [&](uint32_t a, uint32_t c) { return nodes_[a].name < nodes_[c].name; });
+
+                TrieNode& parent = out.nodes[finalOf[b]];
+                parent.firstChild    = static_cast<uint32_t>(out.nodes.size());
+                parent.literalCount  = static_cast<uint16_t>(firstArg - kids.begin());
+                parent.argumentCount = static_cast<uint16_t>(kids.end() - firstArg);
+
+                for (uint32_t kid : kids) {
+                    finalOf[kid] = static_cast<uint32_t>(out.nodes.size());
+                    out.nodes.push_back(makeNode(nodes_[kid], out));
+                    queue.push_back(kid);
+                }
+            }
+
+            // redirects are paths -> resolved once everything has its final index
+            for (uint32_t b : queue) {
+                const BuildNode& node = nodes_[b];
+                TrieNode& flat = out.nodes[finalOf[b]];
+
+                if (!node.redirect.empty()) {
+                    uint32_t target = resolvePath(node.redirect);
+                    flat.redirect = target != TrieNode::NONE ? finalOf[target] : TrieNode::NONE;
+                } else if (b != 0 && node.children.empty() && !node.executable) {
+                    flat.redirect = 0; // "execute run" has nothing after it -> continues at the root
+                }
+            }
+        }
+
+    private:
+        JsonScanner in_;
+        std::vector<BuildNode> nodes_;
+        std::string keyBuf_;
+        std::string valueBuf_;
+        std::unordered_map<std::string, uint32_t> strings_;
+
+        bool parseNode(uint32_t self, int depth) {
+            if (depth > 256 || !in_.consume('{')) return false;
+
+            while (!in_.consume('}')) {
+                std::string_view key;
+                if (!in_.readKey(key, keyBuf_)) return false;
+
+                std::string_view value;
+                if (key == "type") {
+                    if (!in_.readString(value, valueBuf_)) return false;
+                    nodes_[self].isArgument = (value == "argument");
+                } else if (key == "executable") {
+                    if (!in_.readBool(nodes_[self].executable)) return false;
+                } else if (key == "parser") {
+                    if (!in_.readString(value, valueBuf_)) return false;
+                    nodes_[self].parser = value;
+                } else if (key == "required_level") {
+                    if (!in_.readInteger(nodes_[self].level) && !in_.skipValue()) return false;
+                } else if (key == "properties") {
+                    if (!parseProperties(self)) return false;
+                } else if (key == "redirect") {
+                    if (!in_.consume('[')) return false;
+                    while (!in_.consume(']')) {
+                        if (!in_.readString(value, valueBuf_)) return false;
+                        nodes_[self].redirect.emplace_back(value);
+                        in_.consume(',');
+                    }
+                } else if (key == "children") {
+                    if (!in_.consume('{')) return false;
+                    while (!in_.consume('}')) {
+                        std::string_view name;
+                        if (!in_.readKey(name, keyBuf_)) return false;
+
+                        uint32_t child = static_cast<uint32_t>(nodes_.size());
+                        nodes_.emplace_back();
+                        nodes_[child].name = name;
+                        nodes_[self].children.push_back(child);
+
+                        if (!parseNode(child, depth + 1)) return false;
+                        in_.consume(',');
+                    }
+                } else if (!in_.skipValue()) {
+                    return false;
+                }
+                in_.consume(',');
+            }
+            return true;
+        }
+
+        bool parseProperties(uint32_t self) {
+            if (!in_.consume('{')) return false;
+            while (!in_.consume('}')) {
+                std::string_view key;
+                if (!in_.readKey(key, keyBuf_)) return false;
+
+                double number;
+                std::string_view value;
+                if (key == "type" && in_.peek() == '"') {
+                    if (!in_.readString(value, valueBuf_)) return false;
+                    nodes_[self].stringType = value;
+                } else if ((key == "min" || key == "max") && in_.readNumber(number)) {
+                    nodes_[self].hasBounds = true;
+                    (key == "min" ? nodes_[self].bounds.min : nodes_[self].bounds.max) = number;
+                } else if (!in_.skipValue()) {
+                    return false;
+                }
+                in_.consume(',');
+            }
+            return true;
+        }
+
+        uint32_t resolvePath(const std::vector<std::string>& path) const {
+            uint32_t node = 0;
+            for (const auto& part : path) {
+                uint32_t next = TrieNode::NONE;
+                for (uint32_t kid : nodes_[node].children) {
+                    if (!nodes_[kid].isArgument && nodes_[kid].name == part) { next = kid; break; }
+                }
+                if (next == TrieNode::NONE) return TrieNode::NONE;
+                node = next;
+            }
+            return node;
+        }
+
+        uint32_t addString(const std::string& text, CommandTrie::Data& out) {
+            auto [it, inserted] = strings_.emplace(text, static_cast<uint32_t>(out.strings.size()));
+            if (inserted) out.strings += text;
+            return it->second;
+        }
+
+        static ArgKind argKindOf(const BuildNode& node) {
+            const std::string& p = node.parser;
+            if (p == "brigadier:string") {
+                if (node.stringType == "greedy") return ArgKind::GREEDY;
+                if (node.stringType == "phrase") return ArgKind::PHRASE;
+                return ArgKind::STRING;
+            }
+            if (p == "minecraft:message")                                   return ArgKind::GREEDY;
+            if (p == "brigadier:integer" || p == "brigadier:long")          return ArgKind::INTEGER;
+            if (p == "brigadier:float"   || p == "brigadier:double")        return ArgKind::FLOAT;
+            if (p == "brigadier:bool")                                      return ArgKind::BOOL;
+            if (p == "minecraft:vec3"    || p == "minecraft:block_pos")     return ArgKind::COORDS3;
+            if (p == "minecraft:vec2"    || p == "minecraft:column_pos" ||
+                p == "minecraft:rotation")                                  return ArgKind::COORDS2;
+            return ArgKind::WORD;
+        }
+
+        TrieNode makeNode(const BuildNode& node, CommandTrie::Data& out) {
+            TrieNode flat;
+            flat.name       = addString(node.name, out);
+            flat.nameLength = static_cast<uint16_t>(node.name.size());
+            flat.isArgument = node.isArgument;
+            if (node.executable) flat.flags |= TrieNode::EXECUTABLE;
+
+            if (node.isArgument) {
+                flat.parser       = addString(node.parser, out);
+                flat.parserLength = static_cast<uint16_t>(node.parser.size());
+                flat.arg          = argKindOf(node);
+
+                if (node.hasBounds && (flat.arg == ArgKind::INTEGER || flat.arg == ArgKind::FLOAT)) {
+                    flat.flags |= TrieNode::HAS_BOUNDS;
+                    flat.bounds = static_cast<uint32_t>(out.bounds.size());
+                    out.bounds.push_back(node.bounds);
+                }
+            }
+            return flat;
+        }
+    };
+}
+
+bool CommandTrie::build(std::string_view json, int maxLevel, Data& out, std::string* err) {
+    TrieBuilder builder(json);
+    if (!builder.parse(err)) return false;
+    builder.layout(maxLevel, out);
+    return true;
+}
+
+
+// ===== MATCH =====
+
+uint32_t CommandTrie::findLiteral(uint32_t node, std::string_view word) const {
+    const TrieNode& parent = nodes_[node];
+    const TrieNode* first = nodes_.data() + parent.firstChild;
+    const TrieNode* last  = first + parent.literalCount;
+
+    const TrieNode* it = std::lower_bound(first, last, word, [&](const TrieNode& n, std::string_view w) { return name(n) < w; });
+    if (it == last || name(*it) != word) return TrieNode::NONE;
+    return static_cast<uint32_t>(it - nodes_.data());
+}
+
+// Words are separated by spaces, an argument may take more than one word (coordinates, greedy strings)
+// or contain spaces inside quotes / brackets. Follows brigadier: a matching literal wins over arguments.
+namespace {
+    enum CharClass : uint8_t { CC_SPACE = 1, CC_SPECIAL = 2, CC_UNQUOTED = 4 };
+
+    // CC_SPECIAL -> chars that end the fast path of readWord (space, quotes, brackets)
+    constexpr std::array<uint8_t, 256> CHAR_CLASS = [] {
+        std::array<uint8_t, 256> t = {};
+        for (unsigned char c : std::string_view(" \t"))           t[c] |= CC_SPACE | CC_SPECIAL;
+        for (unsigned char c : std::string_view("\"'[]{}()"))     t[c] |= CC_SPECIAL;
+        for (int c = 0; c < 256; c++) {
+            if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) t[c] |= CC_UNQUOTED;
+        }
+        for (unsigned char c : std::string_view("_-.+"))           t[c] |= CC_UNQUOTED;
+        return t;
+    }();
+
+    inline bool has(char c, CharClass cls) { return CHAR_CLASS[static_cast<unsigned char>(c)] & cls; }
+}
+
+struct CommandTrie::Matcher {
+    const CommandTrie& trie;
+    const char* begin;
+    const char* end;
+    const char* furthest;
+
+    static bool isSpace(char c) { return has(c, CC_SPACE); }
+
+    const char* wordEnd(const char* p) const {
+        while (p < end && !isSpace(*p)) p++;
+        return p;
+    }
+
+    bool matchFrom(uint32_t nodeId, const char* p) {
+        while (p < end && isSpace(*p)) p++;
+        if (p > furthest) furthest = p;
+        if (p == end) return trie.nodes_[nodeId].executable();
+
+        uint32_t from = trie.childrenOf(nodeId);
+        const TrieNode& parent = trie.nodes_[from];
+
+        if (parent.literalCount > 0) {
+            const char* we = wordEnd(p);
+            uint32_t literal = trie.findLiteral(from, std::string_view(p, we - p));
+            if (literal != TrieNode::NONE) return matchFrom(literal, we);
+        }
+
+        for (uint32_t i = 0; i < parent.argumentCount; i++) {
+            uint32_t child = parent.firstChild + parent.literalCount + i;
+            const char* e = readArgument(trie.nodes_[child], p);
+            if (e && (e == end || isSpace(*e)) && matchFrom(child, e)) return true;
+        }
+        return false;
+    }
+
+    const char* readArgument(const TrieNode& node, const char* p) const {
+        switch (node.arg) {
+            case ArgKind::GREEDY:   return end;
+            case ArgKind::WORD:     return readWord(p);
+            case ArgKind::STRING:   return readUnquoted(p);
+            case ArgKind::PHRASE:   return (*p == '"' || *p == '\'') ? readQuoted(p) : readUnquoted(p);
+            case ArgKind::BOOL: {
+                std::string_view word(p, wordEnd(p) - p);
+                return (word == "true" || word == "false") ? p + word.size() : nullptr;
+            }
+            case ArgKind::INTEGER:
+            case ArgKind::FLOAT: {
+                const char* we = wordEnd(p);
+                if (scanNumber(p, we, node.arg == ArgKind::FLOAT) != we) return nullptr;
+
+                // the value is only needed for min / max -> most numbers are never converted
+                if (node.flags & TrieNode::HAS_BOUNDS) {
+                    double value;
+                    auto res = std::from_chars(p, we, value, std::chars_format::fixed);
+                    if (res.ec != std::errc()) return nullptr;
+                    const TrieBounds& b = trie.bounds_[node.bounds];
+                    if (value < b.min || value > b.max) return nullptr;
+                }
+                return we;
+            }
+            case ArgKind::COORDS2: return readCoords(p, 2);
+            case ArgKind::COORDS3: return readCoords(p, 3);
+        }
+        return nullptr;
+    }
+
+    // -12, 3.5, .5 -> end of the number syntax (not converted), nullptr if there is no digit
+    static const char* scanNumber(const char* p, const char* end, bool fraction) {
+        if (p < end && *p == '-') p++;
+        const char* digits = p;
+        while (p < end && *p >= '0' && *p <= '9') p++;
+        size_t count = p - digits;
+
+        if (fraction && p < end && *p == '.') {
+            p++;
+            const char* frac = p;
+            while (p < end && *p >= '0' && *p <= '9') p++;
+            count += p - frac;
+        }
+        return count > 0 ? p : nullptr;
+    }
+
+    // one word, spaces are allowed inside quotes and [] {} ()
+    const char* readWord(const char* p) const {
+        const char* start = p;
+        int depth = 0;
+        while (p < end) {
+            // most words have no quotes or brackets at all
+            while (p < end && !has(*p, CC_SPECIAL)) p++;
+            if (p == end) break;
+
+            char c = *p;
+            if (c == '"' || c == '\'') {
+                p = readQuoted(p);
+                if (!p) return nullptr;
+                continue;
+            }
+            if (depth == 0 && isSpace(c)) break;
+            if (c == '[' || c == '{' || c == '(') depth++;
+            else if (c == ']' || c == '}' || c == ')') {
+                if (--depth < 0) return nullptr;
+            }
+            p++;
+        }
+        return (depth == 0 && p > start) ? p : nullptr;
+    }
+
+    const char* readQuoted(const char* p) const {
+        char quote = *p++;
+        while (p < end) {
+            if (*p == '\\') { p += 2; continue; }
+            if (*p == quote) return p + 1;
+            p++;
+        }
+        return nullptr;
+    }
+
+    // brigadier unquoted string
+    const char* readUnquoted(const char* p) const {
+        const char* start = p;
+        while (p < end && has(*p, CC_UNQUOTED)) p++;
+        return p > start ? p : nullptr;
+    }
+
+    // "~ ~1 ~", "^ ^ ^2", "10 64 -3" -> local (^) coordinates can't be mixed with the others
+    const char* readCoords(const char* p, int count) const {
+        int local = 0;
+        for (int i = 0; i < count; i++) {
+            if (i > 0) {
+                if (p == end || *p != ' ') return nullptr;
+                p++;
+            }
+            const char* we = wordEnd(p);
+            if (p == we) return nullptr;
+
+            const char* num = p;
+            if (*p == '~' || *p == '^') {
+                if (*p == '^') local++;
+                num++;
+                if (num == we) { p = we; continue; }
+            }
+            if (scanNumber(num, we, true) != we) return nullptr;
+            p = we;
+        }
+        if (local != 0 && local != count) return nullptr;
+        return p;
+    }
+};
+
+CommandMatch CommandTrie::match(std::string_view command, std::string_view args) const {
+    if (nodes_.empty()) return { false, 0 };
+
+    uint32_t root = findLiteral(0, command);
+    if (root == TrieNode::NONE) return { false, 0 };
+
+    Matcher m = { *this, args.data(), args.data() + args.size(), args.data() };
+    bool ok = m.matchFrom(root, args.data());
+    return { ok, static_cast<size_t>(m.furthest - args.data()) };
+}
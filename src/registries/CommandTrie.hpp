@@ -0,0 +1,102 @@
+// CommandTrie.hpp
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// How the text of an argument node is read, everything that isn't listed is one bracket/quote aware word
+// (selectors with [...], nbt {...}, json components, resource locations, ...).
+enum class ArgKind : uint8_t {
+    WORD,       // one word, spaces inside quotes and brackets are allowed
+    STRING,     // brigadier:string word -> unquoted word only
+    PHRASE,     // brigadier:string phrase -> quoted string or unquoted word
+    GREEDY,     // brigadier:string greedy, minecraft:message -> rest of the command
+    INTEGER,    // brigadier:integer / long
+    FLOAT,      // brigadier:float / double
+    BOOL,       // brigadier:bool
+    COORDS2,    // vec2, column_pos, rotation -> 2 coordinates
+    COORDS3,    // vec3, block_pos -> 3 coordinates
+};
+
+// One node of the flattened command tree. Nodes are stored breadth first in one array and the children
+// of a node are contiguous: literals first (sorted by name -> binary search), then arguments.
+// The struct is written into the registry snapshot as is.
+struct TrieNode {
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    enum Flags : uint8_t { EXECUTABLE = 1, HAS_BOUNDS = 2 };
+
+    uint32_t name = 0;              // offset into strings (literal word / argument name)
+    uint16_t nameLength = 0;
+    uint8_t  isArgument = 0;
+    uint8_t  flags = 0;
+    uint32_t firstChild = 0;
+    uint16_t literalCount = 0;
+    uint16_t argumentCount = 0;
+    uint32_t redirect = NONE;       // children are taken from this node instead (execute ... -> execute, execute run -> root)
+    uint32_t parser = 0;            // offset into strings, argument nodes only
+    uint16_t parserLength = 0;
+    ArgKind  arg = ArgKind::WORD;
+    uint8_t  pad = 0;
+    uint32_t bounds = 0;            // index into bounds if HAS_BOUNDS (brigadier numbers with min / max)
+
+    bool executable() const { return flags & EXECUTABLE; }
+};
+static_assert(sizeof(TrieNode) == 32);
+
+struct TrieBounds {
+    double min;
+    double max;
+};
+
+struct CommandMatch {
+    bool ok = false;
+    size_t errorOffset = 0;     // offset into the arguments of the first part that didn't match
+};
+
+// Read-only view over a compiled command tree (usually straight from the mapped snapshot).
+// Validating a command walks the words once, arguments are backtracked only when a node has more than one.
+class CommandTrie {
+public:
+    // everything the view points to, filled by build() and saved into the snapshot
+    struct Data {
+        std::vector<TrieNode> nodes;    // [0] is the root
+        std::vector<TrieBounds> bounds;
+        std::string strings;
+    };
+
+    CommandTrie() = default;
+    CommandTrie(std::span<const TrieNode> nodes, std::span<const TrieBounds> bounds, std::string_view strings)
+        : nodes_(nodes), bounds_(bounds), strings_(strings) {}
+
+    // compiles the whole commands.json, only commands with required_level <= maxLevel are reachable from the root
+    static bool build(std::string_view json, int maxLevel, Data& out, std::string* err = nullptr);
+
+    // command = top-level name, args = rest of the line (without the name)
+    CommandMatch match(std::string_view command, std::string_view args) const;
+
+    bool empty() const { return nodes_.empty(); }
+    size_t size() const { return nodes_.size(); }
+
+    const TrieNode& node(uint32_t id) const { return nodes_[id]; }
+    std::string_view name(const TrieNode& node) const { return { strings_.data() + node.name, node.nameLength }; }     // offsets are checked when the snapshot is loaded
+    std::string_view parser(const TrieNode& node) const { return { strings_.data() + node.parser, node.parserLength }; }
+
+    // literal child of node with the given name, NONE if there isn't one
+    uint32_t findLiteral(uint32_t node, std::string_view word) const;
+
+    // node whose children are used after node (follows the redirect)
+    uint32_t childrenOf(uint32_t node) const {
+        uint32_t redirect = nodes_[node].redirect;
+        return redirect != TrieNode::NONE ? redirect : node;
+    }
+
+private:
+    std::span<const TrieNode> nodes_;
+    std::span<const TrieBounds> bounds_;
+    std::string_view strings_;
+
+    struct Matcher;
+};
@@ -0,0 +1,158 @@
+// JsonScanner.hpp
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Minimal pull scanner over a mapped json file (commands.json). Values that aren't needed are skipped
+// without being parsed -> only brackets and strings are looked at, nothing is allocated for them.
+class JsonScanner {
+public:
+    explicit JsonScanner(std::string_view text) : begin_(text.data()), p_(text.data()), end_(text.data() + text.size()) {}
+
+    size_t offset() const { return p_ - begin_; }
+
+    // skips whitespace, consumes c if it is next
+    bool consume(char c) {
+        skipWs();
+        if (p_ < end_ && *p_ == c) { p_++; return true; }
+        return false;
+    }
+
+    // next non whitespace char, 0 at the end
+    char peek() {
+        skipWs();
+        return p_ < end_ ? *p_ : 0;
+    }
+
+    // "key": -> out points into the file unless the key had escapes (then into buf)
+    bool readKey(std::string_view& out, std::string& buf) {
+        return readString(out, buf) && consume(':');
+    }
+
+    // "string" -> same as readKey
+    bool readString(std::string_view& out, std::string& buf) {
+        if (!consume('"')) return false;
+        const char* start = p_;
+        p_--;
+        if (!skipString()) return false;
+        std::string_view raw(start, p_ - 1 - start);
+
+        if (raw.find('\\') == std::string_view::npos) { out = raw; return true; }
+
+        // rare -> decode escapes, \u is only supported for ascii (command names are ascii anyway)
+        buf.clear();
+        for (size_t i = 0; i < raw.size(); i++) {
+            char c = raw[i];
+            if (c != '\\' || i + 1 == raw.size()) { buf += c; continue; }
+            switch (char e = raw[++i]) {
+                case 'n': buf += '\n'; break;
+                case 't': buf += '\t'; break;
+                case 'r': buf += '\r'; break;
+                case 'b': buf += '\b'; break;
+                case 'f': buf += '\f'; break;
+                case 'u': {
+                    unsigned code = 0;
+                    auto res = std::from_chars(raw.data() + i + 1, raw.data() + std::min(i + 5, raw.size()), code, 16);
+                    if (res.ptr != raw.data() + i + 5 || code > 0x7F) return false;
+                    buf += static_cast<char>(code);
+                    i += 4;
+                    break;
+                }
+                default: buf += e; break; // \" \\ \/
+            }
+        }
+        out = buf;
+        return true;
+    }
+
+    // false (and nothing consumed) if the value isn't an integer -> caller skips it
+    bool readInteger(int64_t& out) {
+        skipWs();
+        const char* start = p_;
+        const char* q = p_;
+        if (q < end_ && *q == '-') q++;
+        if (q == end_ || *q < '0' || *q > '9') return false;
+
+        int64_t value = 0;
+        for (; q < end_ && *q >= '0' && *q <= '9'; q++) {
+            if (value < INT64_MAX / 10) value = value * 10 + (*q - '0');
+        }
+        if (q < end_ && (*q == '.' || *q == 'e' || *q == 'E')) return false; // float
+
+        out = (*start == '-') ? -value : value;
+        p_ = q;
+        return true;
+    }
+
+    // false (and nothing consumed) if the value isn't a number
+    bool readNumber(double& out) {
+        skipWs();
+        auto res = std::from_chars(p_, end_, out);
+        if (res.ec != std::errc()) return false;
+        p_ = res.ptr;
+        return true;
+    }
+
+    bool readBool(bool& out) {
+        skipWs();
+        std::string_view rest(p_, end_ - p_);
+        if (rest.starts_with("true"))  { out = true;  p_ += 4; return true; }
+        if (rest.starts_with("false")) { out = false; p_ += 5; return true; }
+        return false;
+    }
+
+    bool skipValue() {
+        skipWs();
+        if (p_ == end_) return false;
+
+        if (*p_ == '"') return skipString();
+
+        if (*p_ == '{' || *p_ == '[') {
+            size_t depth = 0;
+            while (p_ < end_) {
+                char c = *p_;
+                if (c == '"') {
+                    if (!skipString()) return false;
+                    continue;
+                }
+                p_++;
+                if (c == '{' || c == '[') depth++;
+                else if ((c == '}' || c == ']') && --depth == 0) return true;
+            }
+            return false;
+        }
+
+        // number, true, false, null
+        const char* start = p_;
+        while (p_ < end_ && *p_ != ',' && *p_ != '}' && *p_ != ']' && !isWs(*p_)) p_++;
+        return p_ != start;
+    }
+
+private:
+    const char* begin_;
+    const char* p_;
+    const char* end_;
+
+    static bool isWs(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+    void skipWs() { while (p_ < end_ && isWs(*p_)) p_++; }
+
+    bool skipString() {
+        p_++; // opening quote
+        while (true) {
+            const void* q = std::memchr(p_, '"', end_ - p_);
+            if (!q) return false;
+            const char* quote = static_cast<const char*>(q);
+
+            // quote is escaped if preceded by an odd number of backslashes
+            size_t slashes = 0;
+            for (const char* b = quote; b > p_ && b[-1] == '\\'; b--) slashes++;
+            p_ = quote + 1;
+            if (slashes % 2 == 0) return true;
+        }
+    }
+};
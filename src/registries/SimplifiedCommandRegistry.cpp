@@ -0,0 +1,263 @@
+// SimplifiedCommandRegistry.cpp
+#include "./SimplifiedCommandRegistry.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+#include "../core/hash.hpp"
+#include "../core/trace.hpp"
+#include "./JsonScanner.hpp"
+
+namespace {
+
+    // ===== SNAPSHOT FORMAT =====
+    // [SnapshotHeader] [uint64 lengthMask[256]] [TrieNode nodes[trieNodes]] [TrieBounds bounds[trieBounds]]
+    // [uint32 nameEnd[count]] [char names[namesSize]] [char trieStrings[trieStringsSize]]
+    // all numbers in host byte order, the snapshot is a cache and never leaves the machine
+    // everything up to nameEnd is 8 byte aligned -> trie nodes are used straight from the mapping
+    constexpr char SNAPSHOT_MAGIC[8] = { 'M', 'C', 'J', 'R', 'E', 'G', '\0', '\0' };
+    constexpr uint32_t SNAPSHOT_VERSION = 2; // bump when the layout or the filtering rules change
+
+    struct SnapshotHeader {
+        char     magic[8];
+        uint32_t version;
+        uint32_t maxLevel;
+        uint64_t sourceHash;    // hash of commands.json the snapshot was built from
+        uint32_t count;
+        uint32_t namesSize;
+        uint32_t trieNodes;
+        uint32_t trieBounds;
+        uint32_t trieStringsSize;
+        uint32_t pad;
+    };
+    static_assert(sizeof(SnapshotHeader) % 8 == 0);
+
+    constexpr size_t MASK_BYTES = 256 * sizeof(uint64_t);
+
+    std::string buildSnapshot(const std::vector<std::string>& roots, const CommandTrie::Data& trie, uint64_t sourceHash, uint32_t maxLevel) {
+        std::array<uint64_t, 256> mask = {};
+        std::vector<uint32_t> ends;
+        std::string names;
+        for (const auto& name : roots) {
+            if (name.empty()) continue;
+            names += name;
+            ends.push_back(static_cast<uint32_t>(names.size()));
+            mask[(unsigned char)name[0]] |= uint64_t(1) << (name.size() < 63 ? name.size() : 63);
+        }
+
+        SnapshotHeader header = {};
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version    = SNAPSHOT_VERSION;
+        header.maxLevel   = maxLevel;
+        header.sourceHash = sourceHash;
+        header.count      = static_cast<uint32_t>(ends.size());
+        header.namesSize  = static_cast<uint32_t>(names.size());
+        header.trieNodes  = static_cast<uint32_t>(trie.nodes.size());
+        header.trieBounds = static_cast<uint32_t>(trie.bounds.size());
+        header.trieStringsSize = static_cast<uint32_t>(trie.strings.size());
+
+        std::string out;
+        out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.append(reinterpret_cast<const char*>(mask.data()), MASK_BYTES);
+        out.append(reinterpret_cast<const char*>(trie.nodes.data()), trie.nodes.size() * sizeof(TrieNode));
+        out.append(reinterpret_cast<const char*>(trie.bounds.data()), trie.bounds.size() * sizeof(TrieBounds));
+        out.append(reinterpret_cast<const char*>(ends.data()), ends.size() * sizeof(uint32_t));
+        out.append(names);
+        out.append(trie.strings);
+        return out;
+    }
+
+    // written to a temp file and renamed -> compilers running at the same time never see half of it
+    void writeSnapshot(const std::string& path, const std::string& data) {
+        std::string tmp = path + ".tmp" + std::to_string(getpid());
+        {
+            std::ofstream f(tmp, std::ios::binary);
+            if (!f) return; // read-only mcdoc dir -> just parse the json every time
+            f.write(data.data(), data.size());
+            if (!f) { f.close(); std::remove(tmp.c_str()); return; }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+        if (ec) std::remove(tmp.c_str());
+    }
+}
+
+
+void SimplifiedCommandRegistry::loadAsync(const std::string& path) {
+    pending_ = std::async(std::launch::async, [this, path] {
+        return loadFromFile(path, &pendingErr_);
+    }).share();
+}
+
+bool SimplifiedCommandRegistry::wait(std::string* err) const {
+    if (!pending_.valid()) return true;
+
+    bool ok = pending_.get();
+    if (!ok && err) *err = pendingErr_;
+    return ok;
+}
+
+bool SimplifiedCommandRegistry::loadFromFile(const std::string& path, std::string *err) {
+    trace::Span span("registry load", path);
+    auto stop = [&] { loadMs_ = span.end().wallNs / 1e6; };
+
+    Source file;
+    if (!file.loadFromFile(path)) {
+        std::cout << "ERROR: Cannot open file: " << path << std::endl;
+
+        // Sprawdź czy plik istnieje
+        if (std::filesystem::exists(path)) {
+            std::cout << "File exists but cannot be opened." << std::endl;
+        } else {
+            std::cout << "File does not exist." << std::endl;
+        }
+
+        return false;
+    }
+
+    uint64_t sourceHash = hashBytes(file.text());
+    sourceHash_ = sourceHash;
+    std::string snapshotPath = path + ".snapshot";
+
+    // fast path -> snapshot built from exactly this json
+    if (mapped_.loadFromFile(snapshotPath) && loadSnapshot(mapped_.text(), sourceHash)) {
+        fromSnapshot_ = true;
+        stop();
+        return true;
+    }
+
+    std::vector<std::string> roots;
+    if (!parseJson(file.text(), roots, err)) return false;
+
+    CommandTrie::Data trie;
+    if (!CommandTrie::build(file.text(), MAX_LEVEL, trie, err)) return false;
+
+    built_ = buildSnapshot(roots, trie, sourceHash, MAX_LEVEL);
+    writeSnapshot(snapshotPath, built_);
+
+    fromSnapshot_ = false;
+    bool ok = loadSnapshot(built_, sourceHash);
+    stop();
+    return ok;
+}
+
+// Only the names & required_level of the top-level commands are needed -> the file is scanned in place
+// and every nested subtree is skipped by matching brackets, nothing is allocated for it.
+bool SimplifiedCommandRegistry::parseJson(std::string_view text, std::vector<std::string>& roots, std::string* err) {
+    JsonScanner in(text);
+
+    auto fail = [&](const char* msg) {
+        if (err) *err = std::string("JSON parse error: ") + msg + " at offset " + std::to_string(in.offset());
+        return false;
+    };
+
+    // root may be object with "type":"root" and "children"
+    if (!in.consume('{')) return fail("expected root object");
+
+    bool foundChildren = false;
+    std::string keyBuf;
+    std::string nameBuf;
+    while (!in.consume('}')) {
+        std::string_view key;
+        if (!in.readKey(key, keyBuf)) return fail("expected key");
+
+        if (key != "children") {
+            if (!in.skipValue()) return fail("invalid value");
+        } else {
+            if (!in.consume('{')) return fail("children is not an object");
+            foundChildren = true;
+
+            while (!in.consume('}')) {
+                // top-level keys are command names: literal nodes
+                std::string_view cmdName;
+                if (!in.readKey(cmdName, nameBuf)) return fail("expected command name");
+                if (!in.consume('{')) return fail("command node is not an object");
+
+                int64_t level = -1;
+                bool hasLevel = false;
+                while (!in.consume('}')) {
+                    std::string_view field;
+                    if (!in.readKey(field, keyBuf)) return fail("expected key");
+
+                    if (field == "required_level" && in.readInteger(level)) {
+                        hasLevel = true;
+                    } else if (!in.skipValue()) {
+                        return fail("invalid value");
+                    }
+                    in.consume(',');
+                }
+
+                if (hasLevel && level >= 0 && level <= MAX_LEVEL) roots.emplace_back(cmdName);
+                in.consume(',');
+            }
+        }
+        in.consume(',');
+    }
+
+    if (!foundChildren) {
+        if (err) *err = "Unexpected JSON format: missing top-level children";
+        return false;
+    }
+    return true;
+}
+
+// false if the snapshot is damaged, from another version or built from a different json
+bool SimplifiedCommandRegistry::loadSnapshot(std::string_view data, uint64_t sourceHash) {
+    SnapshotHeader header;
+    if (data.size() < sizeof(header) + MASK_BYTES) return false;
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) return false;
+    if (header.version != SNAPSHOT_VERSION || header.maxLevel != MAX_LEVEL) return false;
+    if (header.sourceHash != sourceHash) return false;
+
+    size_t nodesOffset   = sizeof(header) + MASK_BYTES;
+    size_t boundsOffset  = nodesOffset + size_t(header.trieNodes) * sizeof(TrieNode);
+    size_t endsOffset    = boundsOffset + size_t(header.trieBounds) * sizeof(TrieBounds);
+    size_t namesOffset   = endsOffset + size_t(header.count) * sizeof(uint32_t);
+    size_t stringsOffset = namesOffset + header.namesSize;
+    if (data.size() != stringsOffset + header.trieStringsSize) return false;
+    if (reinterpret_cast<uintptr_t>(data.data()) % alignof(TrieNode) != 0) return false;
+
+    std::memcpy(lengthMask_.data(), data.data() + sizeof(header), MASK_BYTES);
+
+    const char* names = data.data() + namesOffset;
+    roots_.clear();
+    roots_.reserve(header.count);
+    index_.clear();
+    index_.reserve(header.count);
+
+    uint32_t start = 0;
+    for (uint32_t i = 0; i < header.count; i++) {
+        uint32_t end;
+        std::memcpy(&end, data.data() + endsOffset + i * sizeof(uint32_t), sizeof(end));
+        if (end <= start || end > header.namesSize) return false;
+
+        std::string_view name(names + start, end - start);
+        roots_.push_back(name);
+        index_.insert(name);
+        start = end;
+    }
+
+    std::span<const TrieNode> nodes(reinterpret_cast<const TrieNode*>(data.data() + nodesOffset), header.trieNodes);
+    std::span<const TrieBounds> bounds(reinterpret_cast<const TrieBounds*>(data.data() + boundsOffset), header.trieBounds);
+    std::string_view strings(data.data() + stringsOffset, header.trieStringsSize);
+
+    // a damaged trie must not send the matcher out of bounds
+    for (const TrieNode& node : nodes) {
+        if (size_t(node.firstChild) + node.literalCount + node.argumentCount > nodes.size()) return false;
+        if (node.redirect != TrieNode::NONE && node.redirect >= nodes.size()) return false;
+        if (size_t(node.name) + node.nameLength > strings.size()) return false;
+        if (size_t(node.parser) + node.parserLength > strings.size()) return false;
+        if ((node.flags & TrieNode::HAS_BOUNDS) && node.bounds >= bounds.size()) return false;
+        if (node.arg > ArgKind::COORDS3) return false;
+    }
+
+    // nodes stay in the mapping, the strings are copied -> matching against the mapped copy measured ~2x slower
+    trieStrings_.assign(strings);
+    trie_ = CommandTrie(nodes, bounds, trieStrings_);
+    return true;
+}
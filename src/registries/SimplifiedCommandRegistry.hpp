@@ -1,71 +1,91 @@
 // SimplifiedCommandRegistry.hpp
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
-#include <memory>
-#include <fstream>
-#include <iostream>
+#include <array>
+#include <unordered_set>
+#include <cstdint>
+#include <future>
 
-#include "../../libs/json.hpp"
-using json = nlohmann::json;
+#include "../core/source.hpp"
+#include "./CommandTrie.hpp"
 
+// Top-level command names allowed in the source (CMD_KEY tokens).
+// Immutable after loadFromFile -> all const methods are safe to call from many threads at once.
+//
+// Parsing commands.json is by far the slowest part of compiling a small script, so the names are also
+// saved into a binary snapshot next to it (<path>.snapshot) keyed by the hash of the json. Next runs just
+// map the snapshot, commands.json is only read to check the hash.
+// The snapshot also holds the whole command tree flattened into a CommandTrie (./CommandTrie.hpp), it is
+// used to validate the arguments of raw commands.
+// loadAsync() moves the whole load to a background thread, users call wait() right before the first lookup.
 class SimplifiedCommandRegistry {
 public:
     SimplifiedCommandRegistry() = default;
     ~SimplifiedCommandRegistry() = default;
 
-    // Load data.json (the commands tree)
-    bool loadFromFile(const std::string& path, std::string *err = nullptr) {
-        std::ifstream f(path);
-        if (!f.is_open()) {
-            std::cout << "ERROR: Cannot open file: " << path << std::endl;
-            
-            // Sprawdź czy plik istnieje
-            if (std::filesystem::exists(path)) {
-                std::cout << "File exists but cannot be opened." << std::endl;
-            } else {
-                std::cout << "File does not exist." << std::endl;
-            }
-            
-            return false;
-        }
-        try {
-            json j; f >> j;
-            // root may be object with "type":"root" and "children"
-            if (j.is_object() && j.contains("children")) {
-                auto &children = j["children"];
-                for (auto it = children.begin(); it != children.end(); ++it) {
-                    // top-level keys are command names: literal nodes
-                    std::string cmdName = it.key();
-                    const json& jnode = it.value();
-                    if (
-                        !(jnode.contains("required_level") && jnode["required_level"].is_number_integer()) ||
-                        jnode["required_level"].get<uint8_t>() > MAX_LEVEL
-                    ) continue;
-                    roots.push_back(cmdName);
-                }
-                return true;
-            } else {
-                if (err) *err = "Unexpected JSON format: missing top-level children";
-                return false;
-            }
-        } catch (const std::exception &ex) {
-            if (err) *err = std::string("JSON parse error: ") + ex.what();
-            return false;
-        }
-    }
+    SimplifiedCommandRegistry(const SimplifiedCommandRegistry&) = delete;
+    SimplifiedCommandRegistry& operator=(const SimplifiedCommandRegistry&) = delete;
+
+    // Load data.json (the commands tree), implemented in ./SimplifiedCommandRegistry.cpp
+    bool loadFromFile(const std::string& path, std::string *err = nullptr);
+
+    // starts loadFromFile on a background thread -> reading & lexing the source overlaps with it
+    // nothing else may be called before wait() returned true
+    void loadAsync(const std::string& path);
+
+    // blocks until the background load is done, returns at once after that (or if loadFromFile was used)
+    // safe to call from many threads
+    bool wait(std::string* err = nullptr) const;
 
     // Check if a command name is valid (exists in the registry)
-    bool isValid(const std::string& cmdName) const {
-        bool contains = roots.end() != std::find(roots.begin(), roots.end(), cmdName);
-        return contains;
+    // called for every identifier -> most of them are rejected by the first char/length filter
+    bool isValid(std::string_view cmdName) const {
+        if (cmdName.empty()) return false;
+        if (!(lengthMask_[(unsigned char)cmdName[0]] & lengthBit(cmdName.size()))) return false;
+        return index_.find(cmdName) != index_.end();
     }
 
-    const std::vector<std::string> getRoots() const {
-        return roots;
+    // names point into the snapshot
+    const std::vector<std::string_view>& getRoots() const {
+        return roots_;
     }
 
+    // full command tree, validates the arguments of commands
+    const CommandTrie& trie() const { return trie_; }
+
+    // true if the last load was served from the snapshot
+    bool fromSnapshot() const { return fromSnapshot_; }
+
+    // wall time of the last load (on whatever thread it ran)
+    double loadMs() const { return loadMs_; }
+
+    // hash of the commands.json bytes, changes with the mcdoc ref -> part of compile cache keys
+    uint64_t sourceHash() const { return sourceHash_; }
+
+    static constexpr int MAX_LEVEL = 2;     // max allowed required_level for commands (functions run at level 2)
+
 private:
-    static constexpr int MAX_LEVEL = 2;     // max allowed required_level for commands
-    std::vector<std::string> roots;
+    Source mapped_;             // snapshot mapped from disk
+    std::string built_;         // or snapshot built in memory when it wasn't valid
+    bool fromSnapshot_ = false;
+    double loadMs_ = 0;
+    uint64_t sourceHash_ = 0;
+
+    std::shared_future<bool> pending_;  // valid only after loadAsync
+    std::string pendingErr_;
+
+    CommandTrie trie_;                       // points into the snapshot (and trieStrings_)
+    std::string trieStrings_;
+    std::vector<std::string_view> roots_;    // in mcdoc order
+    std::unordered_set<std::string_view> index_;
+    std::array<uint64_t, 256> lengthMask_ = {}; // [first char] -> bit per name length (63 = 63 and longer)
+
+    static uint64_t lengthBit(size_t length) {
+        return uint64_t(1) << (length < 63 ? length : 63);
+    }
+
+    bool parseJson(std::string_view json, std::vector<std::string>& roots, std::string* err);
+    bool loadSnapshot(std::string_view data, uint64_t sourceHash);
 };